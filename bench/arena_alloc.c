@@ -0,0 +1,213 @@
+/**
+ * @brief
+ *      Cost of millions of small allocations from an `Arena`, through the
+ *      `Allocator` interface, through `arena_rawalloc_inline`, and through
+ *      `malloc` for reference.
+ *
+ *      Allocation must not slow down as blocks pile up, so the interface run
+ *      is also reported per window of allocations.
+ *
+ *      Finally, a fill-and-reset loop like the REPL in `main.c` checks that no
+ *      new blocks are needed once the arena has warmed up, and a scratch
+ *      region loop checks that `arena_temp_end()` gives back everything that
+ *      was allocated since `arena_temp_begin()`, even across blocks.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/arena_alloc.out`
+ */
+#include "bench.h"
+
+#include <stdlib.h> // malloc, free
+
+#define ALLOC_COUNT     10000000
+#define WINDOW_COUNT    5
+
+typedef struct {
+    int   refcount;
+    short kind;
+} Small;
+
+static size_t
+_count_blocks(const Arena *arena)
+{
+    size_t count = 0;
+    for (const Memory_Block *block = arena->begin; block != NULL; block = block->prev)
+        ++count;
+    return count;
+}
+
+static void
+_bench_mem_new(void)
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return;
+
+    Allocator allocator = arena_allocator(&arena);
+    double    window[WINDOW_COUNT];
+    for (size_t w = 0; w < WINDOW_COUNT; ++w) {
+        double start = bench_now_ns();
+        for (size_t i = 0; i < ALLOC_COUNT / WINDOW_COUNT; ++i) {
+            Allocator_Error error;
+            Small          *small = mem_new(Small, &error, allocator);
+            bench_consume(small);
+        }
+        window[w] = (bench_now_ns() - start) / (ALLOC_COUNT / WINDOW_COUNT);
+    }
+
+    eprintfln("mem_new(Small, arena_allocator): %d allocations, %zu blocks", ALLOC_COUNT, _count_blocks(&arena));
+    for (size_t w = 0; w < WINDOW_COUNT; ++w)
+        eprintfln("    window %zu: %6.2f ns/alloc", w, window[w]);
+    arena_destroy(&arena);
+}
+
+static void
+_bench_inline(void)
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return;
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < ALLOC_COUNT; ++i)
+        bench_consume(arena_rawalloc_inline(&arena, sizeof(Small), alignof(Small)));
+    double elapsed = (bench_now_ns() - start) / ALLOC_COUNT;
+
+    eprintfln("arena_rawalloc_inline:           %6.2f ns/alloc", elapsed);
+    arena_destroy(&arena);
+}
+
+static void
+_bench_mixed(void)
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return;
+
+    // Sizes from 8 to 512 bytes leave tails of every size behind. These are
+    // much bigger on average, so do fewer of them.
+    const size_t count = ALLOC_COUNT / 10;
+    uint64_t     state = 0x2545f4914f6cdd1dULL;
+    double       start = bench_now_ns();
+    for (size_t i = 0; i < count; ++i) {
+        size_t size = 8 + (bench_random(&state) & 504);
+        bench_consume(arena_rawalloc(&arena, size, 8));
+    }
+    double elapsed = (bench_now_ns() - start) / cast(double)count;
+
+    eprintfln("arena_rawalloc, 8..512 bytes:    %6.2f ns/alloc, %zu blocks", elapsed, _count_blocks(&arena));
+    arena_destroy(&arena);
+}
+
+#define RESET_WARMUP        10
+#define RESET_ITERATIONS    10000
+#define RESET_MAX_BLOCKS    64
+
+static void
+_bench_recycling(void)
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return;
+
+    const Memory_Block *known[RESET_MAX_BLOCKS];
+    size_t              known_count = 0;
+    size_t              new_blocks  = 0;
+    uint64_t            state       = 0x853c49e6748fea9bULL;
+    double              start       = 0;
+
+    for (size_t iteration = 0; iteration < RESET_ITERATIONS; ++iteration) {
+        if (iteration == RESET_WARMUP)
+            start = bench_now_ns();
+
+        // About 256K per iteration in small pieces.
+        for (size_t i = 0; i < 2000; ++i)
+            bench_consume(arena_rawalloc(&arena, 8 + (bench_random(&state) & 248), 8));
+
+        for (const Memory_Block *block = arena.begin; block != NULL; block = block->prev) {
+            bool is_known = false;
+            for (size_t i = 0; i < known_count && !is_known; ++i)
+                is_known = (known[i] == block);
+            if (is_known)
+                continue;
+            if (iteration >= RESET_WARMUP)
+                ++new_blocks;
+            if (known_count < RESET_MAX_BLOCKS)
+                known[known_count++] = block;
+        }
+        arena_free_all(&arena);
+    }
+    double elapsed = (bench_now_ns() - start) / (RESET_ITERATIONS - RESET_WARMUP);
+
+    eprintfln("fill and reset ~256K:            %6.2f us/iteration, %zu blocks in use, %zu new after warm-up",
+        elapsed / 1000, known_count, new_blocks);
+    arena_destroy(&arena);
+}
+
+#define TEMP_ITERATIONS     100000
+
+static void
+_bench_temp(void)
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return;
+
+    uint64_t state = 0x2545f4914f6cdd1dULL;
+    size_t   kept  = 0;
+    double   start = bench_now_ns();
+    for (size_t iteration = 0; iteration < TEMP_ITERATIONS; ++iteration) {
+        // Something that outlives the region, like a newly interned name.
+        bench_consume(arena_rawalloc(&arena, 16, 8));
+        kept += 16;
+
+        Arena_Temp outer = arena_temp_begin(&arena);
+        for (size_t i = 0; i < 64; ++i)
+            bench_consume(arena_rawalloc(&arena, 8 + (bench_random(&state) & 248), 8));
+
+        // Every so often, make the nested region spill over into new blocks.
+        Arena_Temp inner = arena_temp_begin(&arena);
+        size_t     count = (iteration % 1000 == 0) ? 4096 : 16;
+        for (size_t i = 0; i < count; ++i)
+            bench_consume(arena_rawalloc(&arena, 256, 8));
+        arena_temp_end(inner);
+        arena_temp_end(outer);
+    }
+    double elapsed = (bench_now_ns() - start) / TEMP_ITERATIONS;
+
+    size_t total = 0;
+    size_t used  = arena_get_usage(&arena, &total);
+    eprintfln("scratch regions:                 %6.2f ns/iteration, %zu bytes used (%zu kept), %zu blocks",
+        elapsed, used, kept, _count_blocks(&arena));
+    arena_destroy(&arena);
+}
+
+static void
+_bench_malloc(void)
+{
+    Small **smalls = cast(Small **)malloc(sizeof(smalls[0]) * ALLOC_COUNT);
+    if (smalls == NULL)
+        return;
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < ALLOC_COUNT; ++i)
+        smalls[i] = cast(Small *)malloc(sizeof(Small));
+    double elapsed = (bench_now_ns() - start) / ALLOC_COUNT;
+
+    eprintfln("malloc (reference):              %6.2f ns/alloc", elapsed);
+    for (size_t i = 0; i < ALLOC_COUNT; ++i)
+        free(smalls[i]);
+    free(smalls);
+}
+
+int
+main(void)
+{
+    _bench_mem_new();
+    _bench_inline();
+    _bench_mixed();
+    _bench_recycling();
+    _bench_temp();
+    _bench_malloc();
+    return 0;
+}
@@ -0,0 +1,53 @@
+/**
+ * @brief
+ *      Shared scaffolding for the standalone benchmarks in this directory.
+ *      Each benchmark is its own program, so this header also pulls in the
+ *      implementations of everything it may need.
+ *
+ * @note
+ *      The type parser is very chatty on `stdout`. Benchmarks report on `stderr`
+ *      so you can run them as `./bench/foo.out > /dev/null`.
+ */
+#pragma once
+
+// Must come before any system header for `clock_gettime` to be visible.
+#define _POSIX_C_SOURCE 200809L
+
+#define DSA_IMPLEMENTATION
+
+#include "../mem/allocator.h"
+#include "../mem/arena.h"
+#include "../mem/pool.h"
+#include "../intern.h"
+#include "../types/types.h"
+
+#include <time.h> // clock_gettime
+
+static inline double
+bench_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return cast(double)now.tv_sec * 1e9 + cast(double)now.tv_nsec;
+}
+
+/**
+ * @brief
+ *      Keeps the optimizer from deleting work whose result we never use.
+ */
+static inline void
+bench_consume(const void *ptr)
+{
+    __asm__ volatile("" : : "g"(ptr) : "memory");
+}
+
+// xorshift64; good enough to scramble lookup order without calling `rand`.
+static inline uint64_t
+bench_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
@@ -0,0 +1,87 @@
+/**
+ * @brief
+ *      What `Budget_Allocator` adds to every request, over an `Arena` so that
+ *      the atomic add is not lost in the noise of `malloc`.
+ *
+ *      Then an `Intern` is filled until its budget runs out, with a low
+ *      watermark callback, checking that it fails cleanly at the limit.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/budget.out`
+ */
+#include "bench.h"
+#include "../mem/budget.h"
+
+#define ALLOC_COUNT     10000000
+#define INTERN_LIMIT    (cast(size_t)4 << 20)
+
+typedef struct {
+    int   refcount;
+    short kind;
+} Small;
+
+static double
+_bench(Allocator allocator)
+{
+    double start = bench_now_ns();
+    for (size_t i = 0; i < ALLOC_COUNT; ++i) {
+        Allocator_Error error;
+        bench_consume(mem_new(Small, &error, allocator));
+        // Keep the arena small so that we measure the same thing throughout.
+        if ((i & 0xFFFF) == 0xFFFF)
+            mem_free_all(allocator);
+    }
+    return (bench_now_ns() - start) / ALLOC_COUNT;
+}
+
+static void
+_on_low_watermark(Budget_Allocator *budget, size_t used, void *user_ptr)
+{
+    unused(budget);
+    size_t *calls = cast(size_t *)user_ptr;
+    if ((*calls)++ == 0)
+        eprintfln("    low watermark reached at %zu bytes", used);
+}
+
+static void
+_bench_intern(void)
+{
+    static Budget_Allocator budget;
+    size_t                  calls = 0;
+    budget_allocator_init(&budget, global_heap_allocator, INTERN_LIMIT,
+        INTERN_LIMIT / 4, &_on_low_watermark, &calls);
+
+    Intern intern = intern_make(budget_allocator(&budget));
+    size_t count  = 0;
+    char   buf[64];
+    for (;; ++count) {
+        int    len  = snprintf(buf, sizeof buf, "identifier_%zu", count);
+        String text = intern_get(&intern, (String){buf, cast(size_t)len});
+        if (text.data == NULL)
+            break;
+    }
+    eprintfln("intern: %zu strings in %zu bytes before running out (limit %zu), %zu callback(s), %zu rejected",
+        count, budget_allocator_used(&budget), INTERN_LIMIT, calls, atomic_load(&budget.rejected));
+
+    intern_destroy(&intern);
+    eprintfln("    %zu bytes charged after intern_destroy", budget_allocator_used(&budget));
+}
+
+int
+main(void)
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return 1;
+
+    static Budget_Allocator budget;
+    budget_allocator_init(&budget, arena_allocator(&arena), SIZE_MAX, 0, NULL, NULL);
+
+    double plain     = _bench(arena_allocator(&arena));
+    double budgeted  = _bench(budget_allocator(&budget));
+    eprintfln("mem_new(Small): %5.2f ns plain, %5.2f ns budgeted", plain, budgeted);
+    arena_destroy(&arena);
+
+    _bench_intern();
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @brief
+ *      Bulk-importing 1M types: a `CType` and a `CType_Info` each, allocated
+ *      1 by 1 with `mem_new` or in batches with `mem_make_many`. The batches
+ *      pay for 1 call through `Allocator.fn` instead of 1 per object.
+ *
+ *      The heap has no native batch mode, so there `mem_make_many` shows the
+ *      cost of the generic fallback.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/bulk_import.out`
+ */
+#include "bench.h"
+
+#define TYPE_COUNT      1000000
+#define BATCH_SIZE      256
+#define ROUND_COUNT     3
+
+static CType            *_types[TYPE_COUNT];
+static CType_Info       *_infos[TYPE_COUNT];
+static const CType_Info _pointee = {0};
+
+static void
+_fill(size_t i)
+{
+    _types[i]->kind            = CType_Kind_Pointer;
+    _types[i]->pointer.pointee = &_pointee;
+    _infos[i]->type            = _types[i];
+    _infos[i]->qualifiers      = 0;
+    _infos[i]->is_owner        = true;
+}
+
+static double
+_import_one_by_one(Allocator type_allocator, Allocator info_allocator)
+{
+    double start = bench_now_ns();
+    for (size_t i = 0; i < TYPE_COUNT; ++i) {
+        Allocator_Error error;
+        _types[i] = mem_new(CType, &error, type_allocator);
+        if (error)
+            return 0;
+        _infos[i] = mem_new(CType_Info, &error, info_allocator);
+        if (error)
+            return 0;
+        _fill(i);
+    }
+    return (bench_now_ns() - start) / TYPE_COUNT;
+}
+
+static double
+_import_batched(Allocator type_allocator, Allocator info_allocator)
+{
+    double start = bench_now_ns();
+    for (size_t i = 0; i < TYPE_COUNT; i += BATCH_SIZE) {
+        Allocator_Error error;
+        size_t          count = (TYPE_COUNT - i < BATCH_SIZE) ? TYPE_COUNT - i : BATCH_SIZE;
+        mem_make_many(CType, &error, &_types[i], count, type_allocator);
+        if (error)
+            return 0;
+        mem_make_many(CType_Info, &error, &_infos[i], count, info_allocator);
+        if (error)
+            return 0;
+        for (size_t j = i; j < i + count; ++j)
+            _fill(j);
+    }
+    return (bench_now_ns() - start) / TYPE_COUNT;
+}
+
+typedef enum {
+    Backend_Arena,
+    Backend_Pool,
+    Backend_Heap,
+} Backend;
+
+/**
+ * @brief
+ *      Import with `import` on a fresh `backend` and tear it down again. The
+ *      best of `ROUND_COUNT` rounds is kept, so page faults from the first
+ *      touch of new memory don't count against whichever runs first.
+ */
+static double
+_run(Backend backend, double (*import)(Allocator type_allocator, Allocator info_allocator))
+{
+    double best = 0;
+    for (size_t round = 0; round < ROUND_COUNT; ++round) {
+        double ns = 0;
+        switch (backend) {
+        case Backend_Arena: {
+            Arena arena;
+            if (arena_init(&arena))
+                return 0;
+            ns = import(arena_allocator(&arena), arena_allocator(&arena));
+            arena_destroy(&arena);
+            break;
+        }
+        case Backend_Pool: {
+            Pool type_pool, info_pool;
+            pool_init_type(&type_pool, CType, global_heap_allocator);
+            pool_init_type(&info_pool, CType_Info, global_heap_allocator);
+            ns = import(pool_allocator(&type_pool), pool_allocator(&info_pool));
+            pool_destroy(&type_pool);
+            pool_destroy(&info_pool);
+            break;
+        }
+        case Backend_Heap:
+            ns = import(global_heap_allocator, global_heap_allocator);
+            for (size_t i = 0; i < TYPE_COUNT; ++i) {
+                mem_free(_types[i], global_heap_allocator);
+                mem_free(_infos[i], global_heap_allocator);
+            }
+            break;
+        }
+        if (round == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+int
+main(void)
+{
+    static const char *const names[] = {"arena:", "pool:", "heap:"};
+    for (Backend backend = Backend_Arena; backend <= Backend_Heap; ++backend) {
+        double one     = _run(backend, &_import_one_by_one);
+        double batched = _run(backend, &_import_batched);
+        eprintfln("%-6s %6.2f ns/type 1 by 1, %6.2f ns/type batched%s", names[backend], one, batched,
+            (backend == Backend_Heap) ? " (fallback)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @brief
+ *      Producer/consumer throughput of `Concurrent_Allocator`. In each pair,
+ *      the producer allocates `Intern_String`s and passes them through a ring
+ *      buffer to the consumer, which checks and frees them. Every object is
+ *      thus freed by a different thread than the one which allocated it.
+ *
+ *      The shared backend is a `Tlsf`, which is not thread-safe. It is
+ *      measured behind `Concurrent_Allocator`, behind a plain mutex, and
+ *      against `malloc` (which has its own per-thread caches) for reference.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/concurrent_allocator.out [max_pairs]`
+ *
+ *      With fewer cores than threads, the pairs take turns and the numbers
+ *      say more about context switches than about contention.
+ */
+#include "bench.h"
+#include "../mem/concurrent_allocator.h"
+#include "../mem/tlsf.h"
+
+#include <pthread.h>
+#include <sched.h>  // sched_yield
+#include <stdatomic.h>
+#include <stdlib.h> // atoi
+#include <unistd.h> // sysconf
+
+#define OBJECTS_PER_PAIR    1000000
+#define RING_SIZE           1024
+#define MAX_PAIRS           32
+#define TLSF_SIZE           (cast(size_t)256 << 20)
+
+typedef struct {
+    Allocator         allocator;
+    Intern_String    *ring[RING_SIZE];
+    _Atomic(size_t)   head;     // Written by the producer only.
+    _Atomic(size_t)   tail;     // Written by the consumer only.
+    size_t            failures;
+    size_t            corrupt;
+} Pair;
+
+static size_t
+_string_size(size_t len)
+{
+    // Same as `_intern_set`, including the nul terminator.
+    return sizeof(Intern_String) + len + 1;
+}
+
+static void *
+_producer(void *user_ptr)
+{
+    Pair  *pair = cast(Pair *)user_ptr;
+    size_t head = 0;
+    for (size_t i = 0; i < OBJECTS_PER_PAIR; ++i) {
+        size_t          len    = 8 + i % 56;
+        Allocator_Error error;
+        Intern_String  *string = cast(Intern_String *)mem_rawnew(&error, _string_size(len), alignof(Intern_String), pair->allocator);
+        if (error) {
+            pair->failures++;
+            continue;
+        }
+        string->len  = cast(uint32_t)len;
+        string->hash = cast(uint32_t)i;
+        memset(string->data, 'a' + cast(int)(i % 26), len);
+        string->data[len] = '\0';
+
+        while (head - atomic_load_explicit(&pair->tail, memory_order_acquire) == RING_SIZE)
+            sched_yield();
+        pair->ring[head % RING_SIZE] = string;
+        atomic_store_explicit(&pair->head, ++head, memory_order_release);
+    }
+    // `NULL` tells the consumer we are done.
+    while (head - atomic_load_explicit(&pair->tail, memory_order_acquire) == RING_SIZE)
+        sched_yield();
+    pair->ring[head % RING_SIZE] = NULL;
+    atomic_store_explicit(&pair->head, ++head, memory_order_release);
+    return NULL;
+}
+
+static void *
+_consumer(void *user_ptr)
+{
+    Pair  *pair = cast(Pair *)user_ptr;
+    size_t tail = 0;
+    for (;;) {
+        while (atomic_load_explicit(&pair->head, memory_order_acquire) == tail)
+            sched_yield();
+        Intern_String *string = pair->ring[tail % RING_SIZE];
+        atomic_store_explicit(&pair->tail, ++tail, memory_order_release);
+        if (string == NULL)
+            break;
+
+        char expect = cast(char)('a' + cast(int)(string->hash % 26));
+        if (string->data[0] != expect || string->data[string->len - 1] != expect || string->data[string->len] != '\0')
+            pair->corrupt++;
+        mem_rawfree(string, _string_size(string->len), pair->allocator);
+    }
+    return NULL;
+}
+
+static double
+_throughput(Allocator allocator, size_t pair_count, size_t *out_bad)
+{
+    static Pair pairs[MAX_PAIRS];
+    pthread_t   handles[2 * MAX_PAIRS];
+    double      start = bench_now_ns();
+    for (size_t p = 0; p < pair_count; ++p) {
+        pairs[p].allocator = allocator;
+        pairs[p].failures  = 0;
+        pairs[p].corrupt   = 0;
+        atomic_init(&pairs[p].head, 0);
+        atomic_init(&pairs[p].tail, 0);
+        pthread_create(&handles[2 * p],     NULL, &_producer, &pairs[p]);
+        pthread_create(&handles[2 * p + 1], NULL, &_consumer, &pairs[p]);
+    }
+    for (size_t t = 0; t < 2 * pair_count; ++t)
+        pthread_join(handles[t], NULL);
+    double elapsed = bench_now_ns() - start;
+
+    for (size_t p = 0; p < pair_count; ++p)
+        *out_bad += pairs[p].failures + pairs[p].corrupt;
+    // Millions of objects allocated and freed per second, across all pairs.
+    return cast(double)(OBJECTS_PER_PAIR * pair_count) / (elapsed / 1e3);
+}
+
+// What we would have to do without `Concurrent_Allocator`.
+typedef struct {
+    pthread_mutex_t mutex;
+    Tlsf            tlsf;
+} Locked_Tlsf;
+
+static void *
+_locked_tlsf_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Locked_Tlsf *locked = cast(Locked_Tlsf *)user_ptr;
+    pthread_mutex_lock(&locked->mutex);
+    void *data = tlsf_allocator(&locked->tlsf).fn(out_error, &locked->tlsf, mode, args);
+    pthread_mutex_unlock(&locked->mutex);
+    return data;
+}
+
+static bool
+_bench(size_t pair_count)
+{
+    Tlsf        tlsf;
+    Locked_Tlsf locked;
+    if (tlsf_init_mmap(&tlsf, TLSF_SIZE))
+        return false;
+    if (tlsf_init_mmap(&locked.tlsf, TLSF_SIZE)) {
+        tlsf_destroy(&tlsf);
+        return false;
+    }
+    pthread_mutex_init(&locked.mutex, NULL);
+
+    Concurrent_Allocator concurrent;
+    if (concurrent_allocator_init(&concurrent, tlsf_allocator(&tlsf))) {
+        tlsf_destroy(&tlsf);
+        tlsf_destroy(&locked.tlsf);
+        return false;
+    }
+
+    size_t    bad              = 0;
+    Allocator locked_allocator = {.fn = &_locked_tlsf_fn, .user_ptr = &locked};
+    double    magazines        = _throughput(concurrent_allocator(&concurrent), pair_count, &bad);
+    double    mutex            = _throughput(locked_allocator, pair_count, &bad);
+    double    heap             = _throughput(global_heap_allocator, pair_count, &bad);
+    eprintfln("%2zu pair(s): %7.2f M objects/s (mutex + Tlsf: %7.2f, malloc: %7.2f), %zu failed or corrupted",
+        pair_count, magazines, mutex, heap, bad);
+
+    concurrent_allocator_destroy(&concurrent);
+    pthread_mutex_destroy(&locked.mutex);
+    tlsf_destroy(&locked.tlsf);
+    tlsf_destroy(&tlsf);
+    return bad == 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    long   cpus      = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_pairs = (argc > 1) ? cast(size_t)atoi(argv[1]) : cast(size_t)((cpus > 1) ? cpus / 2 : 1);
+    if (max_pairs < 1)
+        max_pairs = 1;
+    if (max_pairs > MAX_PAIRS)
+        max_pairs = MAX_PAIRS;
+
+    eprintfln("%ld core(s)", cpus);
+    bool ok = true;
+    for (size_t n = 1; n <= max_pairs; n *= 2)
+        ok = _bench(n) && ok;
+    if (max_pairs & (max_pairs - 1))
+        ok = _bench(max_pairs) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/**
+ * @brief
+ *      Stress test and throughput of `Concurrent_Arena`.
+ *
+ *      The stress test has every thread allocate with random sizes and
+ *      alignments, fill each allocation with its own pattern and check it all
+ *      once every thread is done. Any overlap between 2 allocations shows up as
+ *      a corrupted pattern. Exits with 1 if anything is off.
+ *
+ *      Throughput is measured at 1 to N threads, against a plain `Arena` behind
+ *      a mutex and against the per-thread `global_temp_allocator` for reference.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/concurrent_arena.out [max_threads]`
+ */
+#include "bench.h"
+#include "../mem/concurrent_arena.h"
+
+#include <pthread.h>
+#include <stdlib.h> // malloc, free, atoi
+#include <unistd.h> // sysconf
+
+#define STRESS_ALLOCS   200000
+#define BENCH_ALLOCS    2000000
+#define MAX_THREADS     64
+
+typedef struct {
+    unsigned char *ptr;
+    size_t         size;
+} Stress_Alloc;
+
+typedef struct {
+    Allocator     allocator;
+    size_t        id;
+    Stress_Alloc *allocs;
+    size_t        failures;
+} Stress_Thread;
+
+static void *
+_stress_thread(void *user_ptr)
+{
+    Stress_Thread *thread = cast(Stress_Thread *)user_ptr;
+    uint64_t       state  = 0x9e3779b97f4a7c15ULL * (thread->id + 1);
+    for (size_t i = 0; i < STRESS_ALLOCS; ++i) {
+        uint64_t        r     = bench_random(&state);
+        size_t          size  = 1 + (r & 255);
+        size_t          align = cast(size_t)1 << ((r >> 8) % 7);
+        Allocator_Error error = Allocator_Error_None;
+
+        // Now and then: something that needs its own block, or a resize.
+        if (i % 10000 == 0)
+            size = CONCURRENT_ARENA_MAX_BLOCK_SIZE / 2;
+
+        unsigned char *ptr = cast(unsigned char *)mem_rawnew(&error, size, align, thread->allocator);
+        if (error || (cast(uintptr_t)ptr & (align - 1)) != 0) {
+            ++thread->failures;
+            continue;
+        }
+        memset(ptr, cast(int)(thread->id + i), size);
+
+        if (i % 7 == 0) {
+            size_t new_size = size * 2;
+            ptr = cast(unsigned char *)mem_rawresize(&error, ptr, size, new_size, align, thread->allocator);
+            if (error) {
+                ++thread->failures;
+                continue;
+            }
+            memset(ptr + size, cast(int)(thread->id + i), new_size - size);
+            size = new_size;
+        }
+        thread->allocs[i].ptr  = ptr;
+        thread->allocs[i].size = size;
+    }
+    return NULL;
+}
+
+static bool
+_stress(size_t thread_count)
+{
+    Concurrent_Arena arena;
+    if (concurrent_arena_init(&arena))
+        return false;
+
+    Stress_Thread threads[MAX_THREADS];
+    pthread_t     handles[MAX_THREADS];
+    for (size_t t = 0; t < thread_count; ++t) {
+        threads[t].allocator = concurrent_arena_allocator(&arena);
+        threads[t].id        = t;
+        threads[t].allocs    = cast(Stress_Alloc *)calloc(STRESS_ALLOCS, sizeof(Stress_Alloc));
+        threads[t].failures  = 0;
+        pthread_create(&handles[t], NULL, &_stress_thread, &threads[t]);
+    }
+
+    size_t failures = 0;
+    size_t corrupt  = 0;
+    for (size_t t = 0; t < thread_count; ++t) {
+        pthread_join(handles[t], NULL);
+        failures += threads[t].failures;
+        for (size_t i = 0; i < STRESS_ALLOCS; ++i) {
+            Stress_Alloc  *alloc   = &threads[t].allocs[i];
+            unsigned char  pattern = cast(unsigned char)(t + i);
+            for (size_t j = 0; j < alloc->size; ++j) {
+                if (alloc->ptr[j] != pattern) {
+                    ++corrupt;
+                    break;
+                }
+            }
+        }
+        free(threads[t].allocs);
+    }
+
+    size_t total = 0;
+    size_t used  = concurrent_arena_get_usage(&arena, &total);
+    eprintfln("stress, %2zu threads: %zu failed, %zu corrupted, %zu of %zu bytes used",
+        thread_count, failures, corrupt, used, total);
+    concurrent_arena_destroy(&arena);
+    return failures == 0 && corrupt == 0;
+}
+
+typedef struct {
+    Allocator allocator;
+    size_t    count;
+} Bench_Thread;
+
+static void *
+_bench_thread(void *user_ptr)
+{
+    Bench_Thread *thread = cast(Bench_Thread *)user_ptr;
+    for (size_t i = 0; i < thread->count; ++i) {
+        Allocator_Error error = Allocator_Error_None;
+        bench_consume(mem_rawnew(&error, 32, 8, thread->allocator));
+    }
+    // Only does anything if `allocator` was `global_temp_allocator`.
+    global_temp_allocator_destroy();
+    return NULL;
+}
+
+// What we would have to do without `Concurrent_Arena`.
+typedef struct {
+    pthread_mutex_t mutex;
+    Arena           arena;
+} Locked_Arena;
+
+static void *
+_locked_arena_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Locked_Arena *locked = cast(Locked_Arena *)user_ptr;
+    pthread_mutex_lock(&locked->mutex);
+    void *data = arena_allocator(&locked->arena).fn(out_error, &locked->arena, mode, args);
+    pthread_mutex_unlock(&locked->mutex);
+    return data;
+}
+
+static double
+_throughput(Allocator allocator, size_t thread_count)
+{
+    Bench_Thread threads[MAX_THREADS];
+    pthread_t    handles[MAX_THREADS];
+    double       start = bench_now_ns();
+    for (size_t t = 0; t < thread_count; ++t) {
+        threads[t].allocator = allocator;
+        threads[t].count     = BENCH_ALLOCS / thread_count;
+        pthread_create(&handles[t], NULL, &_bench_thread, &threads[t]);
+    }
+    for (size_t t = 0; t < thread_count; ++t)
+        pthread_join(handles[t], NULL);
+
+    // Millions of allocations per second, across all threads.
+    return BENCH_ALLOCS / ((bench_now_ns() - start) / 1e3);
+}
+
+static void
+_bench(size_t thread_count)
+{
+    Concurrent_Arena arena;
+    Locked_Arena     locked;
+    if (concurrent_arena_init(&arena))
+        return;
+    if (arena_init(&locked.arena)) {
+        concurrent_arena_destroy(&arena);
+        return;
+    }
+    pthread_mutex_init(&locked.mutex, NULL);
+
+    Allocator locked_allocator = {.fn = &_locked_arena_fn, .user_ptr = &locked};
+    double    concurrent       = _throughput(concurrent_arena_allocator(&arena), thread_count);
+    double    mutex            = _throughput(locked_allocator, thread_count);
+    double    local            = _throughput(global_temp_allocator, thread_count);
+    eprintfln("throughput, %2zu threads: %8.2f M allocs/s (mutex + Arena: %8.2f, thread-local Arena: %8.2f)",
+        thread_count, concurrent, mutex, local);
+
+    pthread_mutex_destroy(&locked.mutex);
+    arena_destroy(&locked.arena);
+    concurrent_arena_destroy(&arena);
+}
+
+int
+main(int argc, char *argv[])
+{
+    long   cpus        = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = (argc > 1) ? cast(size_t)atoi(argv[1]) : cast(size_t)((cpus > 0) ? cpus : 1);
+    if (max_threads < 1)
+        max_threads = 1;
+    if (max_threads > MAX_THREADS)
+        max_threads = MAX_THREADS;
+
+    bool ok = true;
+    for (size_t n = 1; n <= max_threads; n *= 2)
+        ok = _stress(n) && ok;
+    if (max_threads & (max_threads - 1))
+        ok = _stress(max_threads) && ok;
+
+    for (size_t n = 1; n <= max_threads; n *= 2)
+        _bench(n);
+    if (max_threads & (max_threads - 1))
+        _bench(max_threads);
+    return ok ? 0 : 1;
+}
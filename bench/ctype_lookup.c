@@ -0,0 +1,101 @@
+/**
+ * @brief
+ *      Lookup latency of `CType_Table` by canonical name, comparing the hash
+ *      index against the linear scan over `entries` that it replaced.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/ctype_lookup.out > /dev/null`
+ *
+ *      The table always starts with the basic types, so the smallest size is
+ *      really `CType_BasicKind_Count` entries.
+ */
+#include "bench.h"
+
+#include <string.h> // strlen
+
+// Bijective base-8 numbering so that every `n` spells a distinct type.
+static size_t
+_spell_type(char *buf, size_t cap, size_t n)
+{
+    static const char *const qualifiers[] = {"", "const ", "volatile ", "const volatile "};
+    static const char *const pointer_qualifiers[] = {
+        "", "const ", "volatile ", "const volatile ", "restrict ",
+        "const restrict ", "volatile restrict ", "const volatile restrict ",
+    };
+    const size_t basic_count = CType_BasicKind_Count - 1; // Skip `<invalid>`.
+
+    size_t basic = n % (basic_count * count_of(qualifiers));
+    size_t len   = cast(size_t)snprintf(buf, cap, "%s%s",
+        qualifiers[basic / basic_count],
+        ctype_basic_types[1 + basic % basic_count].basic.name.data);
+
+    for (size_t levels = n / (basic_count * count_of(qualifiers)); levels > 0; levels /= 8) {
+        --levels;
+        len += cast(size_t)snprintf(buf + len, cap - len, " *%s", pointer_qualifiers[levels % 8]);
+    }
+    return len;
+}
+
+static const CType_Info *
+_linear_lookup(const CType_Table *table, Intern_Id name)
+{
+    for (size_t i = 0, len = table->len; i < len; ++i) {
+        if (table->entries[i].name == name)
+            return table->entries[i].info;
+    }
+    return NULL;
+}
+
+static void
+_bench_size(size_t target)
+{
+    Intern      intern = intern_make(global_panic_allocator);
+    CType_Table table;
+    if (ctype_table_init(&table, &intern, global_panic_allocator))
+        return;
+
+    char buf[256];
+    for (size_t n = 0; table.len < target; ++n) {
+        size_t len = _spell_type(buf, sizeof buf, n);
+        ctype_get(&table, buf, len);
+        mem_free_all(global_temp_allocator);
+    }
+
+    const size_t lookups = 1000000;
+    uint64_t     state   = 0x9e3779b97f4a7c15ULL;
+    double       start   = bench_now_ns();
+    for (size_t i = 0; i < lookups; ++i) {
+        Intern_Id name = table.entries[bench_random(&state) % table.len].name;
+        bench_consume(ctype_table_lookup(&table, name));
+    }
+    double indexed = (bench_now_ns() - start) / cast(double)lookups;
+
+    // Keep the total scanning work bounded for the larger tables.
+    const size_t scans = (table.len < 100000000) ? 100000000 / table.len : 1;
+    start = bench_now_ns();
+    for (size_t i = 0; i < scans; ++i) {
+        Intern_Id name = table.entries[bench_random(&state) % table.len].name;
+        bench_consume(_linear_lookup(&table, name));
+    }
+    double linear = (bench_now_ns() - start) / cast(double)scans;
+
+    eprintfln("%10zu entries: index %8.1f ns/lookup, linear scan %12.1f ns/lookup",
+        table.len, indexed, linear);
+
+    ctype_table_destroy(&table);
+    intern_destroy(&intern);
+}
+
+int
+main(void)
+{
+    if (global_temp_allocator_init())
+        return 1;
+
+    const size_t sizes[] = {10, 10000, 1000000};
+    for (size_t i = 0; i < count_of(sizes); ++i)
+        _bench_size(sizes[i]);
+
+    global_temp_allocator_destroy();
+    return 0;
+}
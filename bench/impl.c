@@ -0,0 +1,6 @@
+/**
+ * @brief
+ *      The implementations for the C++ benchmarks. They can only include the C
+ *      headers for their declarations, so this is built as C and linked in.
+ */
+#include "bench.h"
@@ -0,0 +1,155 @@
+/**
+ * @brief
+ *      Throughput of the `Intern` hash functions by key length, then the same
+ *      for `intern_get` on keys which are already interned, which is what the
+ *      type parser mostly does. Last, collisions over a million identifiers,
+ *      counting all 64 bits and only the low 32.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/intern_hash.out`
+ */
+#include "bench.h"
+
+#include <stdlib.h> // malloc, free, qsort
+
+#define BYTES_PER_LENGTH    (cast(size_t)64 << 20)
+#define KEY_COUNT           1024
+#define LOOKUP_COUNT        2000000
+#define COLLISION_KEYS      1000000
+
+typedef struct {
+    const char       *name;
+    Intern_Hash_Kind  kind;
+} Hash_Case;
+
+static const Hash_Case CASES[] = {
+    {"wide",   Intern_Hash_Kind_Wide},
+    {"crc32c", Intern_Hash_Kind_CRC32C},
+    {"fnv1a",  Intern_Hash_Kind_FNV1A},
+};
+
+static const size_t LENGTHS[] = {4, 8, 16, 24, 32, 64, 128, 256, 1024};
+
+#define CASE_COUNT      (sizeof(CASES) / sizeof(CASES[0]))
+#define LENGTH_COUNT    (sizeof(LENGTHS) / sizeof(LENGTHS[0]))
+
+static void
+_fill_random(char *buf, size_t len, uint64_t *state)
+{
+    // Identifier-ish bytes.
+    static const char ALPHABET[] = "abcdefghijklmnopqrstuvwxyz_0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    for (size_t i = 0; i < len; ++i)
+        buf[i] = ALPHABET[bench_random(state) % (sizeof(ALPHABET) - 1)];
+}
+
+static double
+_bench_hash(Intern_Hash hash, const char *keys, size_t len)
+{
+    size_t   rounds = BYTES_PER_LENGTH / (len * KEY_COUNT) + 1;
+    uint64_t sink   = 0;
+    double   start  = bench_now_ns();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t k = 0; k < KEY_COUNT; ++k) {
+            String key = {keys + k * len, len};
+            sink += hash(key);
+        }
+    }
+    double elapsed = bench_now_ns() - start;
+    bench_consume(&sink);
+    // Nanoseconds per key.
+    return elapsed / cast(double)(rounds * KEY_COUNT);
+}
+
+static double
+_bench_lookup(Intern_Hash hash, const char *keys, size_t len)
+{
+    Intern intern = intern_make_with_hash(global_heap_allocator, hash);
+    for (size_t k = 0; k < KEY_COUNT; ++k) {
+        String key = {keys + k * len, len};
+        intern_get(&intern, key);
+    }
+
+    uint64_t state = 42;
+    double   start = bench_now_ns();
+    for (size_t i = 0; i < LOOKUP_COUNT; ++i) {
+        size_t k   = bench_random(&state) % KEY_COUNT;
+        String key = {keys + k * len, len};
+        bench_consume(intern_get(&intern, key).data);
+    }
+    double elapsed = bench_now_ns() - start;
+    intern_destroy(&intern);
+    return elapsed / LOOKUP_COUNT;
+}
+
+static int
+_compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *cast(const uint64_t *)a;
+    uint64_t y = *cast(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t
+_count_duplicates(uint64_t *hashes, size_t count)
+{
+    qsort(hashes, count, sizeof(hashes[0]), &_compare_u64);
+    size_t duplicates = 0;
+    for (size_t i = 1; i < count; ++i)
+        duplicates += hashes[i] == hashes[i - 1];
+    return duplicates;
+}
+
+static void
+_bench_collisions(Intern_Hash hash, const char *name)
+{
+    uint64_t *full = cast(uint64_t *)malloc(COLLISION_KEYS * sizeof(uint64_t));
+    uint64_t *low  = cast(uint64_t *)malloc(COLLISION_KEYS * sizeof(uint64_t));
+    char      buf[64];
+    for (size_t i = 0; i < COLLISION_KEYS; ++i) {
+        int len = snprintf(buf, sizeof buf, "identifier_%zu", i);
+        full[i] = hash((String){buf, cast(size_t)len});
+        low[i]  = full[i] & 0xFFFFFFFF;
+    }
+    size_t full_duplicates = _count_duplicates(full, COLLISION_KEYS);
+    size_t low_duplicates  = _count_duplicates(low, COLLISION_KEYS);
+    eprintfln("%-7s %d keys: %zu collisions in 64 bits, %zu in the low 32",
+        name, COLLISION_KEYS, full_duplicates, low_duplicates);
+    free(full);
+    free(low);
+}
+
+int
+main(void)
+{
+    size_t max_len = LENGTHS[LENGTH_COUNT - 1];
+    char  *keys    = cast(char *)malloc(max_len * KEY_COUNT);
+    if (keys == NULL)
+        return 1;
+
+    eprintf("%-22s", "ns/hash (GB/s)");
+    for (size_t c = 0; c < CASE_COUNT; ++c)
+        eprintf("%20s", CASES[c].name);
+    eprintln("");
+    for (size_t l = 0; l < LENGTH_COUNT; ++l) {
+        size_t   len   = LENGTHS[l];
+        uint64_t state = 0x9e3779b97f4a7c15ULL;
+        _fill_random(keys, len * KEY_COUNT, &state);
+
+        eprintf("  %4zu bytes %10s", len, "hash");
+        for (size_t c = 0; c < CASE_COUNT; ++c) {
+            double ns = _bench_hash(intern_hash_get(CASES[c].kind), keys, len);
+            eprintf("%11.2f (%5.2f)", ns, cast(double)len / ns);
+        }
+        eprintln("");
+
+        eprintf("  %4zu bytes %10s", len, "intern_get");
+        for (size_t c = 0; c < CASE_COUNT; ++c)
+            eprintf("%11.2f %7s", _bench_lookup(intern_hash_get(CASES[c].kind), keys, len), "");
+        eprintln("");
+    }
+    free(keys);
+
+    for (size_t c = 0; c < CASE_COUNT; ++c)
+        _bench_collisions(intern_hash_get(CASES[c].kind), CASES[c].name);
+    return 0;
+}
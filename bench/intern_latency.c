@@ -0,0 +1,106 @@
+/**
+ * @brief
+ *      Tail latency of `intern_get` while `Intern` keeps growing: every call
+ *      is timed on its own, so the few that land on a resize show up in the
+ *      p99, p999 and max rather than being averaged away. Resizes are done
+ *      all at once (`migrate_step = 0`), then a bit on every call.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/intern_latency.out [millions]`
+ *
+ *      Every call also pays for 2 reads of the clock, about 20-30 ns.
+ */
+#include "bench.h"
+
+#include <stdlib.h> // atoi, malloc, free, qsort
+
+typedef struct {
+    const char *name;
+    size_t      hits_per_insert;
+} Workload;
+
+static const Workload WORKLOADS[] = {
+    {"inserts only",  0},
+    {"1 hit/insert",  1},
+};
+
+static size_t
+_spell_key(char *buf, size_t cap, size_t n)
+{
+    return cast(size_t)snprintf(buf, cap, "ctype_table_entry_%zx", cast(size_t)(n * 0x9e3779b97f4a7c15ULL));
+}
+
+static int
+_compare_float(const void *a, const void *b)
+{
+    float x = *cast(const float *)a;
+    float y = *cast(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static double
+_percentile(const float *sorted, size_t count, double p)
+{
+    size_t i = cast(size_t)(p * cast(double)(count - 1));
+    return sorted[i];
+}
+
+static void
+_bench(const Workload *workload, size_t migrate_step, size_t inserts, float *latencies)
+{
+    Intern   intern = intern_make(global_heap_allocator);
+    char     buf[64];
+    uint64_t state  = 0x2545F4914F6CDD1DULL;
+    size_t   calls  = 0;
+    intern.migrate_step = migrate_step;
+
+    double total = bench_now_ns();
+    for (size_t i = 0; i < inserts; ++i) {
+        String key   = {buf, _spell_key(buf, sizeof buf, i)};
+        double start = bench_now_ns();
+        bench_consume(intern_get(&intern, key).data);
+        latencies[calls++] = cast(float)(bench_now_ns() - start);
+
+        for (size_t h = 0; h < workload->hits_per_insert; ++h) {
+            key.len = _spell_key(buf, sizeof buf, bench_random(&state) % (i + 1));
+            start   = bench_now_ns();
+            bench_consume(intern_get(&intern, key).data);
+            latencies[calls++] = cast(float)(bench_now_ns() - start);
+        }
+    }
+    total = (bench_now_ns() - total) / cast(double)calls;
+
+    qsort(latencies, calls, sizeof(latencies[0]), &_compare_float);
+    eprintfln("%-13s %-12s %7.1f ns/call: p50 %7.1f, p99 %7.1f, p999 %9.1f, max %11.1f ns",
+        workload->name,
+        (migrate_step == 0) ? "all at once" : "incremental",
+        total,
+        _percentile(latencies, calls, 0.50),
+        _percentile(latencies, calls, 0.99),
+        _percentile(latencies, calls, 0.999),
+        cast(double)latencies[calls - 1]);
+    intern_destroy(&intern);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t inserts = ((argc > 1) ? cast(size_t)atoi(argv[1]) : 4) * 1000000;
+    size_t most    = 0;
+    for (size_t w = 0; w < count_of(WORKLOADS); ++w) {
+        if (WORKLOADS[w].hits_per_insert > most)
+            most = WORKLOADS[w].hits_per_insert;
+    }
+
+    float *latencies = cast(float *)malloc(inserts * (most + 1) * sizeof(float));
+    if (latencies == NULL)
+        return 1;
+
+    eprintfln("%zuM strings", inserts / 1000000);
+    for (size_t w = 0; w < count_of(WORKLOADS); ++w) {
+        _bench(&WORKLOADS[w], 0, inserts, latencies);
+        _bench(&WORKLOADS[w], INTERN_MIGRATE_STEP, inserts, latencies);
+    }
+    free(latencies);
+    return 0;
+}
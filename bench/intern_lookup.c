@@ -0,0 +1,101 @@
+/**
+ * @brief
+ *      Hit and miss latency of `Intern` lookups once it holds 1M and 10M
+ *      strings, far more than fit in cache. Hits look up a random string that
+ *      is interned; misses look up one that is not, and intern it. The same
+ *      again with `intern_find`, whose misses intern nothing.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/intern_lookup.out [max_millions]`
+ *
+ *      10M strings take about 1 GiB.
+ */
+#include "bench.h"
+
+#include <stdlib.h> // atoi
+
+#define LOOKUP_COUNT    2000000
+
+static size_t
+_spell_key(char *buf, size_t cap, size_t n)
+{
+    // Identifier-like, with a prefix shared by all keys as in real code.
+    return cast(size_t)snprintf(buf, cap, "ctype_table_entry_%zx", cast(size_t)(n * 0x9e3779b97f4a7c15ULL));
+}
+
+static void
+_bench(size_t count)
+{
+    Intern intern = intern_make(global_heap_allocator);
+    char   buf[64];
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < count; ++i) {
+        String key = {buf, _spell_key(buf, sizeof buf, i)};
+        if (intern_get(&intern, key).data == NULL) {
+            eprintfln("out of memory at %zu strings", i);
+            intern_destroy(&intern);
+            return;
+        }
+    }
+    double build = (bench_now_ns() - start) / cast(double)count;
+
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    start = bench_now_ns();
+    for (size_t i = 0; i < LOOKUP_COUNT; ++i) {
+        String key = {buf, _spell_key(buf, sizeof buf, bench_random(&state) % count)};
+        bench_consume(intern_get(&intern, key).data);
+    }
+    double hit = (bench_now_ns() - start) / LOOKUP_COUNT;
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < LOOKUP_COUNT; ++i) {
+        String key = {buf, _spell_key(buf, sizeof buf, bench_random(&state) % count)};
+        bench_consume(intern_find(&intern, key));
+    }
+    double find_hit = (bench_now_ns() - start) / LOOKUP_COUNT;
+
+    // Fresh keys, so each lookup misses. Stop short of the next resize.
+    size_t misses = LOOKUP_COUNT;
+    if (misses > count / 8)
+        misses = count / 8;
+    start = bench_now_ns();
+    for (size_t i = 0; i < misses; ++i) {
+        String key = {buf, _spell_key(buf, sizeof buf, count + i)};
+        bench_consume(intern_find(&intern, key));
+    }
+    double find_miss = (bench_now_ns() - start) / cast(double)misses;
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < misses; ++i) {
+        String key = {buf, _spell_key(buf, sizeof buf, count + i)};
+        bench_consume(intern_get(&intern, key).data);
+    }
+    double miss = (bench_now_ns() - start) / cast(double)misses;
+
+    eprintfln("%5zuM strings: build %6.1f ns/string, hit %6.1f ns, miss %6.1f ns, %zu slots, max probe %d",
+        count / 1000000, build, hit, miss, intern.cap, intern.max_probe);
+    eprintfln("%14s intern_find: hit %6.1f ns, miss %6.1f ns", "", find_hit, find_miss);
+    intern_destroy(&intern);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t max_millions = (argc > 1) ? cast(size_t)atoi(argv[1]) : 10;
+
+    // Included in every number below.
+    char     buf[64];
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    double   start = bench_now_ns();
+    for (size_t i = 0; i < LOOKUP_COUNT; ++i) {
+        _spell_key(buf, sizeof buf, bench_random(&state) % 1000000);
+        bench_consume(buf);
+    }
+    eprintfln("spelling a key: %.1f ns", (bench_now_ns() - start) / LOOKUP_COUNT);
+
+    _bench(1000000);
+    if (max_millions >= 10)
+        _bench(10000000);
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @brief
+ *      Memory taken by `Intern` per string, over a corpus of real identifiers:
+ *      every distinct C identifier in the given files. This counts what the
+ *      heap really holds, i.e. `malloc`'s own header and rounding, or whole
+ *      pages for large objects, and not only what `Intern` asked for.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/intern_memory.out [files...]`
+ *
+ *      Defaults to this repository's own sources. For a bigger corpus, try
+ *      `./bench/intern_memory.out $(find /usr/include -name '*.h')`.
+ */
+#include "bench.h"
+
+#include <ctype.h>     // isalpha, isalnum
+#include <glob.h>      // glob
+#include <malloc.h>    // malloc_usable_size
+#include <stdlib.h>    // malloc, free
+
+typedef struct {
+    size_t bytes;       // Heap footprint of everything live.
+    size_t allocations; // Live allocations.
+} Footprint;
+
+static size_t
+_footprint_of(void *ptr, size_t size)
+{
+    if (ptr == NULL)
+        return 0;
+    if (size >= HEAP_LARGE_THRESHOLD)
+        return (size + 4095) & ~cast(size_t)4095;
+    // glibc keeps 1 `size_t` of header in front of every chunk.
+    return malloc_usable_size(ptr) + sizeof(size_t);
+}
+
+static void *
+_footprint_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Footprint *footprint = cast(Footprint *)user_ptr;
+    size_t     old_bytes = 0;
+    if (mode == Allocator_Mode_Resize || mode == Allocator_Mode_Free)
+        old_bytes = _footprint_of(args.old_ptr, args.old_size);
+
+    void *data = global_heap_allocator.fn(out_error, global_heap_allocator.user_ptr, mode, args);
+    if (*out_error)
+        return data;
+
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+    case Allocator_Mode_Alloc_Zeroed:
+        footprint->bytes += _footprint_of(data, args.new_size);
+        footprint->allocations++;
+        break;
+    case Allocator_Mode_Resize:
+        footprint->bytes += _footprint_of(data, args.new_size) - old_bytes;
+        if (args.old_ptr == NULL)
+            footprint->allocations++;
+        break;
+    case Allocator_Mode_Free:
+        footprint->bytes -= old_bytes;
+        if (args.old_ptr != NULL)
+            footprint->allocations--;
+        break;
+    default:
+        break;
+    }
+    return data;
+}
+
+static char *
+_read_file(const char *path, size_t *out_len)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long  len  = ftell(file);
+    char *data = (len > 0) ? cast(char *)malloc(cast(size_t)len) : NULL;
+    fseek(file, 0, SEEK_SET);
+    if (data != NULL)
+        *out_len = fread(data, 1, cast(size_t)len, file);
+    fclose(file);
+    return data;
+}
+
+static void
+_intern_file(Intern *intern, const char *path, size_t *out_total_len)
+{
+    size_t len  = 0;
+    char  *text = _read_file(path, &len);
+    if (text == NULL)
+        return;
+    for (size_t i = 0; i < len; /* empty */) {
+        if (!isalpha(cast(unsigned char)text[i]) && text[i] != '_') {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        while (i < len && (isalnum(cast(unsigned char)text[i]) || text[i] == '_'))
+            ++i;
+
+        size_t count  = intern->count;
+        String ident  = {&text[start], i - start};
+        intern_get(intern, ident);
+        if (intern->count != count)
+            *out_total_len += ident.len;
+    }
+    free(text);
+}
+
+int
+main(int argc, char *argv[])
+{
+    Footprint footprint = {0, 0};
+    Allocator allocator = {.fn = &_footprint_fn, .user_ptr = &footprint};
+    Intern    intern    = intern_make(allocator);
+    size_t    total_len = 0;
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i)
+            _intern_file(&intern, argv[i], &total_len);
+    } else {
+        static const char *const patterns[] = {"*.[ch]", "mem/*.h", "types/*.[ch]", "bench/*.[ch]"};
+        for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); ++p) {
+            glob_t paths;
+            if (glob(patterns[p], 0, NULL, &paths) != 0)
+                continue;
+            for (size_t i = 0; i < paths.gl_pathc; ++i)
+                _intern_file(&intern, paths.gl_pathv[i], &total_len);
+            globfree(&paths);
+        }
+    }
+    if (intern.count == 0) {
+        eprintln("no identifiers found");
+        return 1;
+    }
+
+    double count = cast(double)intern.count;
+    eprintfln("%zu distinct identifiers, %.1f bytes long on average", intern.count, cast(double)total_len / count);
+    eprintfln("%.1f bytes per string in total, in %zu allocations (%zu slots)",
+        cast(double)footprint.bytes / count, footprint.allocations, intern.cap);
+    intern_destroy(&intern);
+    eprintfln("%zu bytes in %zu allocations left after intern_destroy", footprint.bytes, footprint.allocations);
+    return 0;
+}
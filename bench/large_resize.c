@@ -0,0 +1,83 @@
+/**
+ * @brief
+ *      Growing 1 buffer up to 256 MiB, doubling each time like `String_Builder`
+ *      and `Intern` do, with `realloc` against `global_heap_allocator`. Only
+ *      the resizes are timed. Each new half is written to, so that the next
+ *      resize has real pages to move.
+ *
+ *      Small allocations are made between resizes, as a program would, so
+ *      that `malloc` can't always grow its chunk in place.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/large_resize.out`
+ */
+#include "bench.h"
+
+#include <stdlib.h> // malloc, realloc, free
+#include <string.h> // memset
+
+#define START_SIZE      (cast(size_t)1 << 12)
+#define END_SIZE        (cast(size_t)1 << 28)
+#define ROUND_COUNT     3
+#define NOISE_COUNT     64
+
+static double
+_grow(Allocator *allocator)
+{
+    void  *noise[NOISE_COUNT * 32];
+    size_t noise_count = 0;
+    size_t size        = START_SIZE;
+    char  *buffer      = cast(char *)malloc(size);
+    if (allocator != NULL) {
+        free(buffer);
+        Allocator_Error error;
+        buffer = cast(char *)mem_rawnew(&error, size, 1, *allocator);
+    }
+    if (buffer == NULL)
+        return 0;
+    memset(buffer, 1, size);
+
+    double total = 0;
+    while (size < END_SIZE) {
+        for (size_t i = 0; i < NOISE_COUNT && noise_count < count_of(noise); ++i)
+            noise[noise_count++] = malloc(64);
+
+        size_t new_size = size * 2;
+        char  *data;
+        double start = bench_now_ns();
+        if (allocator != NULL) {
+            Allocator_Error error;
+            data = cast(char *)mem_rawresize(&error, buffer, size, new_size, 1, *allocator);
+        } else {
+            data = cast(char *)realloc(buffer, new_size);
+        }
+        total += bench_now_ns() - start;
+        if (data == NULL)
+            break;
+
+        memset(data + size, 1, new_size - size);
+        buffer = data;
+        size   = new_size;
+    }
+
+    if (allocator != NULL)
+        mem_rawfree(buffer, size, *allocator);
+    else
+        free(buffer);
+    for (size_t i = 0; i < noise_count; ++i)
+        free(noise[i]);
+    return total / 1e6;
+}
+
+int
+main(void)
+{
+    Allocator heap = global_heap_allocator;
+    for (size_t round = 0; round < ROUND_COUNT; ++round) {
+        double by_realloc = _grow(NULL);
+        double by_heap    = _grow(&heap);
+        eprintfln("%zu MiB in doublings: %7.2f ms of realloc, %7.2f ms of global_heap_allocator",
+            END_SIZE >> 20, by_realloc, by_heap);
+    }
+    return 0;
+}
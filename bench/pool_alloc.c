@@ -0,0 +1,86 @@
+/**
+ * @brief
+ *      Memory footprint and allocation time of `Pool` against the heap for
+ *      `CType_Info`-sized objects: first a straight run of allocations then
+ *      frees, then random churn that exercises the free list.
+ *
+ *      Heap footprint is taken from `mallinfo2()`, so it is only reported
+ *      with glibc.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/pool_alloc.out`
+ */
+#include "bench.h"
+
+#include <stdlib.h> // malloc, free
+
+#ifdef __GLIBC__
+#include <malloc.h> // mallinfo2
+#endif // __GLIBC__
+
+#define OBJECT_COUNT    1000000
+#define CHURN_COUNT     10000000
+
+static size_t
+_heap_in_use(void)
+{
+#ifdef __GLIBC__
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif // __GLIBC__
+}
+
+static void
+_bench(const char *name, Allocator allocator, Pool *pool)
+{
+    CType_Info **objects = cast(CType_Info **)malloc(sizeof(objects[0]) * OBJECT_COUNT);
+    if (objects == NULL)
+        return;
+
+    size_t before = _heap_in_use();
+    double start  = bench_now_ns();
+    for (size_t i = 0; i < OBJECT_COUNT; ++i) {
+        Allocator_Error error;
+        objects[i] = mem_new(CType_Info, &error, allocator);
+    }
+    double alloc_ns = (bench_now_ns() - start) / OBJECT_COUNT;
+
+    // Pool slabs come from the heap too, so this covers both.
+    size_t footprint = _heap_in_use() - before;
+    if (pool != NULL)
+        pool_get_usage(pool, &footprint);
+
+    // Churn: free a random object and allocate a new one in its place.
+    uint64_t state = 0x2545f4914f6cdd1dULL;
+    start = bench_now_ns();
+    for (size_t i = 0; i < CHURN_COUNT; ++i) {
+        Allocator_Error error;
+        size_t          j = cast(size_t)(bench_random(&state) % OBJECT_COUNT);
+        mem_free(objects[j], allocator);
+        objects[j] = mem_new(CType_Info, &error, allocator);
+    }
+    double churn_ns = (bench_now_ns() - start) / CHURN_COUNT;
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < OBJECT_COUNT; ++i)
+        mem_free(objects[i], allocator);
+    double free_ns = (bench_now_ns() - start) / OBJECT_COUNT;
+
+    eprintfln("%-5s %5.2f ns/alloc, %5.2f ns/free, %5.2f ns/churn, %5.2f bytes/object (sizeof = %zu)",
+        name, alloc_ns, free_ns, churn_ns, cast(double)footprint / OBJECT_COUNT, sizeof(CType_Info));
+    free(objects);
+}
+
+int
+main(void)
+{
+    Pool pool;
+    pool_init_type(&pool, CType_Info, global_heap_allocator);
+
+    _bench("heap:", global_heap_allocator, NULL);
+    _bench("pool:", pool_allocator(&pool), &pool);
+    pool_destroy(&pool);
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @brief
+ *      `mem_new` through `arena_allocator` and `pool_allocator`, against
+ *      `mem_new_static` on the `Arena *` and `Pool *` themselves. The first
+ *      makes an indirect call per allocation, the second inlines the bump or
+ *      the free list pop.
+ *
+ *      Allocations are made in rounds which end with a reset, so that the
+ *      arena reuses its blocks and the numbers are not about page faults.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/static_dispatch.out`
+ *      See `bench/static_dispatch_cpp.cpp` for the C++ templates.
+ */
+#include "bench.h"
+#include "../mem/dispatch.h"
+
+#define ROUND_COUNT     100
+#define ROUND_SIZE      100000
+
+static void
+_bench_arena(void)
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return;
+
+    Allocator allocator = arena_allocator(&arena);
+    double    start     = bench_now_ns();
+    for (size_t round = 0; round < ROUND_COUNT; ++round) {
+        for (size_t i = 0; i < ROUND_SIZE; ++i) {
+            Allocator_Error error;
+            CType_Info     *info = mem_new(CType_Info, &error, allocator);
+            bench_consume(info);
+        }
+        arena_free_all(&arena);
+    }
+    double dynamic_ns = (bench_now_ns() - start) / (ROUND_COUNT * ROUND_SIZE);
+
+    start = bench_now_ns();
+    for (size_t round = 0; round < ROUND_COUNT; ++round) {
+        for (size_t i = 0; i < ROUND_SIZE; ++i) {
+            Allocator_Error error;
+            CType_Info     *info = mem_new_static(CType_Info, &error, &arena);
+            bench_consume(info);
+        }
+        arena_free_all(&arena);
+    }
+    double static_ns = (bench_now_ns() - start) / (ROUND_COUNT * ROUND_SIZE);
+
+    eprintfln("arena: %5.2f ns/alloc through Allocator, %5.2f ns/alloc static", dynamic_ns, static_ns);
+    arena_destroy(&arena);
+}
+
+static void
+_bench_pool(void)
+{
+    static CType_Info *infos[ROUND_SIZE];
+
+    Pool pool;
+    pool_init_type(&pool, CType_Info, global_heap_allocator);
+
+    // Free everything at the end of a round, so the next one pops the free list.
+    Allocator allocator = pool_allocator(&pool);
+    double    start     = bench_now_ns();
+    for (size_t round = 0; round < ROUND_COUNT; ++round) {
+        for (size_t i = 0; i < ROUND_SIZE; ++i) {
+            Allocator_Error error;
+            infos[i] = mem_new(CType_Info, &error, allocator);
+        }
+        for (size_t i = 0; i < ROUND_SIZE; ++i)
+            mem_free(infos[i], allocator);
+    }
+    double dynamic_ns = (bench_now_ns() - start) / (ROUND_COUNT * ROUND_SIZE);
+
+    start = bench_now_ns();
+    for (size_t round = 0; round < ROUND_COUNT; ++round) {
+        for (size_t i = 0; i < ROUND_SIZE; ++i) {
+            Allocator_Error error;
+            infos[i] = mem_new_static(CType_Info, &error, &pool);
+        }
+        for (size_t i = 0; i < ROUND_SIZE; ++i)
+            mem_free_static(infos[i], &pool);
+    }
+    double static_ns = (bench_now_ns() - start) / (ROUND_COUNT * ROUND_SIZE);
+
+    eprintfln("pool:  %5.2f ns/alloc+free through Allocator, %5.2f ns/alloc+free static", dynamic_ns, static_ns);
+    pool_destroy(&pool);
+}
+
+int
+main(void)
+{
+    _bench_arena();
+    _bench_pool();
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @brief
+ *      The C++ side of `bench/static_dispatch.c`: `mem_rawnew` through
+ *      `arena_allocator`, against `dsa::new_object` on the `Arena *`, whose
+ *      bump is inlined by the template.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/static_dispatch_cpp.out`
+ */
+#include <chrono>
+#include <cstdio>
+
+#include "../mem/allocator.hpp"
+
+struct Node {
+    Node *next;
+    int   value;
+};
+
+static const size_t round_count = 100;
+static const size_t round_size  = 100000;
+
+static double
+now_ns()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+template<class Backing>
+static double
+bench(Arena *arena, Backing backing)
+{
+    double start = now_ns();
+    for (size_t round = 0; round < round_count; ++round) {
+        for (size_t i = 0; i < round_size; ++i) {
+            Allocator_Error error;
+            Node           *node = dsa::new_object<Node>(&error, backing);
+            __asm__ volatile("" : : "g"(node) : "memory");
+        }
+        arena_free_all(arena);
+    }
+    return (now_ns() - start) / static_cast<double>(round_count * round_size);
+}
+
+int
+main()
+{
+    Arena arena;
+    if (arena_init(&arena))
+        return 1;
+
+    double dynamic_ns = bench(&arena, arena_allocator(&arena));
+    double static_ns  = bench(&arena, &arena);
+    std::fprintf(stderr, "arena: %5.2f ns/alloc through Allocator, %5.2f ns/alloc with dsa::new_object\n",
+        dynamic_ns, static_ns);
+    arena_destroy(&arena);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * @brief
+ *      Per-operation latency of `Tlsf` against `malloc`, both behind the
+ *      `Allocator` interface, under a random mix of allocations, resizes and
+ *      frees. What matters is the tail: p99.9 and the worst case.
+ *
+ *      Then `Intern`, `String_Builder` and `CType_Table` are run on top of
+ *      a `Tlsf`, checking that everything is given back once they are gone.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/tlsf_latency.out > /dev/null`
+ */
+#include "bench.h"
+#include "../mem/tlsf.h"
+
+#include <stdlib.h> // malloc, free, qsort
+#include <string.h> // memset
+
+#define SLOT_COUNT      10000
+#define OP_COUNT        2000000
+#define POOL_SIZE       (cast(size_t)256 << 20)
+
+static size_t
+_random_size(uint64_t *state)
+{
+    uint64_t r = bench_random(state);
+    switch (r % 100) {
+    case 0:  return 4096 + (r >> 8) % 61440; // 1%: up to 64K
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+    case 5:
+    case 6:
+    case 7:
+    case 8:
+    case 9:
+    case 10: return 256 + (r >> 8) % 3840;   // 10%: up to 4K
+    default: return 16 + (r >> 8) % 240;
+    }
+}
+
+static int
+_compare_double(const void *a, const void *b)
+{
+    double x = *cast(const double *)a;
+    double y = *cast(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void
+_bench(const char *name, Allocator allocator)
+{
+    void  **slots     = cast(void **)calloc(SLOT_COUNT, sizeof(slots[0]));
+    size_t *sizes     = cast(size_t *)calloc(SLOT_COUNT, sizeof(sizes[0]));
+    double *latencies = cast(double *)malloc(sizeof(latencies[0]) * OP_COUNT);
+    if (slots == NULL || sizes == NULL || latencies == NULL)
+        goto cleanup;
+
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (size_t op = 0; op < OP_COUNT; ++op) {
+        size_t          i     = cast(size_t)(bench_random(&state) % SLOT_COUNT);
+        size_t          size  = _random_size(&state);
+        Allocator_Error error = Allocator_Error_None;
+        double          start = bench_now_ns();
+        if (slots[i] == NULL) {
+            slots[i] = mem_rawnew(&error, size, 16, allocator);
+        } else if (op & 1) {
+            void *data = mem_rawresize(&error, slots[i], sizes[i], size, 16, allocator);
+            if (!error)
+                slots[i] = data;
+        } else {
+            mem_rawfree(slots[i], sizes[i], allocator);
+            slots[i] = NULL;
+        }
+        latencies[op] = bench_now_ns() - start;
+
+        // Touch the memory like a real caller would, outside of the timing.
+        if (slots[i] != NULL && !error) {
+            sizes[i] = size;
+            memset(slots[i], 0xAB, size);
+        }
+    }
+
+    qsort(latencies, OP_COUNT, sizeof(latencies[0]), &_compare_double);
+    eprintfln("%-7s p50 %6.0f ns, p99 %6.0f ns, p99.9 %6.0f ns, max %8.0f ns",
+        name,
+        latencies[OP_COUNT / 2],
+        latencies[OP_COUNT / 100 * 99],
+        latencies[OP_COUNT / 1000 * 999],
+        latencies[OP_COUNT - 1]);
+
+    for (size_t i = 0; i < SLOT_COUNT; ++i)
+        mem_rawfree(slots[i], sizes[i], allocator);
+cleanup:
+    free(latencies);
+    free(sizes);
+    free(slots);
+}
+
+static void
+_bench_clients(Tlsf *tlsf)
+{
+    Allocator   allocator = tlsf_allocator(tlsf);
+    Intern      intern    = intern_make(allocator);
+    CType_Table table;
+    if (ctype_table_init(&table, &intern, allocator))
+        return;
+
+    static const char *const spellings[] = {
+        "int *", "const char **", "unsigned long", "volatile double *const *",
+        "long double complex", "signed char *restrict",
+    };
+    String_Builder builder = string_builder_make(allocator);
+    char           buf[64];
+    for (size_t i = 0; i < 100000; ++i) {
+        int len = snprintf(buf, sizeof buf, "identifier_%zu", i);
+        intern_get(&intern, (String){buf, cast(size_t)len});
+        string_append_cstring(&builder, buf);
+    }
+    for (size_t i = 0; i < count_of(spellings); ++i) {
+        String text = string_from_cstring(spellings[i]);
+        ctype_get(&table, text.data, text.len);
+    }
+
+    size_t used = tlsf->used;
+    string_builder_destroy(&builder);
+    ctype_table_destroy(&table);
+    intern_destroy(&intern);
+    eprintfln("clients: %zu bytes in use with Intern, String_Builder and CType_Table, %zu after",
+        used, tlsf->used);
+}
+
+int
+main(void)
+{
+    static Tlsf tlsf;
+    if (tlsf_init_mmap(&tlsf, POOL_SIZE))
+        return 1;
+
+    _bench("malloc:", global_heap_allocator);
+    _bench("tlsf:", tlsf_allocator(&tlsf));
+    _bench_clients(&tlsf);
+
+    tlsf_destroy(&tlsf);
+    global_temp_allocator_destroy();
+    return 0;
+}
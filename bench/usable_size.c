@@ -0,0 +1,50 @@
+/**
+ * @brief
+ *      How many reallocations a growing `String_Builder` makes when it adopts
+ *      the usable size reported by its allocator, per allocator.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/usable_size.out`
+ */
+#include "bench.h"
+#include "../mem/tlsf.h"
+
+#define APPEND_COUNT    100000
+
+static void
+_bench(const char *name, Allocator allocator)
+{
+    String_Builder builder = string_builder_make(allocator);
+    size_t         resizes = 0;
+    size_t         cap     = 0;
+    double         start   = bench_now_ns();
+    for (size_t i = 0; i < APPEND_COUNT; ++i) {
+        string_append_cstring(&builder, "unsigned long ");
+        if (builder.cap != cap) {
+            cap = builder.cap;
+            ++resizes;
+        }
+    }
+    double elapsed = (bench_now_ns() - start) / APPEND_COUNT;
+
+    eprintfln("%-6s %zu bytes in a buffer of %zu, %zu resizes, %5.2f ns/append",
+        name, builder.len, builder.cap, resizes, elapsed);
+    string_builder_destroy(&builder);
+}
+
+int
+main(void)
+{
+    static Tlsf tlsf;
+    Arena       arena;
+    if (arena_init(&arena) || tlsf_init_mmap(&tlsf, cast(size_t)64 << 20))
+        return 1;
+
+    _bench("heap:", global_heap_allocator);
+    _bench("arena:", arena_allocator(&arena));
+    _bench("tlsf:", tlsf_allocator(&tlsf));
+
+    tlsf_destroy(&tlsf);
+    arena_destroy(&arena);
+    return 0;
+}
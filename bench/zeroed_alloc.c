@@ -0,0 +1,78 @@
+/**
+ * @brief
+ *      Cost of getting a large zeroed table, as `_intern_resize` does, with
+ *      `mem_make` followed by `memset` against `mem_make_zeroed`. The table is
+ *      then filled in sparsely, like a hash table right after it has grown.
+ *
+ *      Page faults are counted along with the time: when the OS hands out
+ *      zero pages, `mem_make_zeroed` never touches the ones we don't use.
+ *
+ * @note
+ *      Usage: `make bench && ./bench/zeroed_alloc.out`
+ */
+#include "bench.h"
+
+#include <string.h>       // memset
+#include <sys/resource.h> // getrusage
+
+#define TABLE_SIZE      (cast(size_t)64 << 20)
+#define ROUND_COUNT     16
+#define FILL_STRIDE     (cast(size_t)1 << 14)
+
+static long
+_minor_faults(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+/**
+ * @param arena
+ *      If non-`NULL`, the virtual arena behind `allocator`. It is mapped anew
+ *      every round, as if a fresh one was made for each table.
+ */
+static void
+_bench(const char *name, Allocator allocator, Arena *arena, bool zeroed)
+{
+    long   faults = _minor_faults();
+    double start  = bench_now_ns();
+    for (size_t round = 0; round < ROUND_COUNT; ++round) {
+        if (arena != NULL && arena_init_virtual(arena, 0, 0))
+            return;
+
+        Allocator_Error error;
+        char           *table;
+        if (zeroed) {
+            table = mem_make_zeroed(char, &error, TABLE_SIZE, allocator);
+        } else {
+            table = mem_make(char, &error, TABLE_SIZE, allocator);
+            if (!error)
+                memset(table, 0, TABLE_SIZE);
+        }
+        if (error)
+            return;
+
+        for (size_t i = 0; i < TABLE_SIZE; i += FILL_STRIDE)
+            table[i] = 1;
+        bench_consume(table);
+
+        mem_delete(table, TABLE_SIZE, allocator);
+        if (arena != NULL)
+            arena_destroy(arena);
+    }
+    double elapsed = (bench_now_ns() - start) / ROUND_COUNT / 1e6;
+    eprintfln("%-22s %7.3f ms/table, %7ld page faults/table",
+        name, elapsed, (_minor_faults() - faults) / ROUND_COUNT);
+}
+
+int
+main(void)
+{
+    Arena arena;
+    _bench("heap, memset:", global_heap_allocator, NULL, false);
+    _bench("heap, zeroed:", global_heap_allocator, NULL, true);
+    _bench("virtual arena, memset:", arena_allocator(&arena), &arena, false);
+    _bench("virtual arena, zeroed:", arena_allocator(&arena), &arena, true);
+    return 0;
+}
@@ -14,6 +14,11 @@
 #define unused(expression)  cast(void)(expression)
 #endif // unused
 
+// Lets the headers be included from C++ too, e.g. by `mem/allocator.hpp`.
+#if defined(__cplusplus) && !defined(_Static_assert)
+#define _Static_assert static_assert
+#endif // __cplusplus
+
 #ifndef count_of
 #define count_of(literal) (sizeof(literal) / sizeof((literal)[0]))
 #endif // count_of
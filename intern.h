@@ -11,23 +11,104 @@
 #include "strings.h"
 #include "mem/allocator.h"
 
-// Opaque type so you don't get any funny ideas!
+// Opaque types so you don't get any funny ideas!
 typedef struct Intern_Entry Intern_Entry;
+typedef struct Intern_Chunk Intern_Chunk;
 
-typedef struct {
-    Allocator     allocator;
-    Intern_Entry *entries;
-    size_t        count;
-    size_t        cap; // Must always be a power of 2.
-    int           max_probe;
-} Intern;
+#ifndef INTERN_CHUNK_SIZE
+// Size of the first chunk of string storage, header included. Later chunks
+// double in size up to `INTERN_CHUNK_MAX_SIZE`.
+#define INTERN_CHUNK_SIZE       4096
+#endif // INTERN_CHUNK_SIZE
+
+#ifndef INTERN_CHUNK_MAX_SIZE
+// Strings too long for a chunk this big get a chunk of their own.
+#define INTERN_CHUNK_MAX_SIZE   (1 << 20)
+#endif // INTERN_CHUNK_MAX_SIZE
+
+#ifndef INTERN_MIGRATE_STEP
+// Default `Intern.migrate_step`. Must be 0 or at least 1 for every call that
+// can insert; see `Intern`.
+#define INTERN_MIGRATE_STEP     8
+#endif // INTERN_MIGRATE_STEP
+
+/**
+ * @brief
+ *      Hashes the key of an `Intern`. Must be the same for equal strings.
+ */
+typedef uint64_t (*Intern_Hash)(String text);
+
+typedef enum {
+    Intern_Hash_Kind_Wide,   // `intern_hash_wide`.
+    Intern_Hash_Kind_CRC32C, // SSE4.2 `crc32` if the CPU has it, else FNV-1a.
+    Intern_Hash_Kind_FNV1A,  // `intern_hash_fnv1a`.
+} Intern_Hash_Kind;
 
+/**
+ * @brief
+ *      A dense 32-bit handle to an interned string: the first string interned
+ *      is 1, the next is 2 and so on. Half the size of a pointer, usable as an
+ *      index into side arrays, and the same from 1 run to the next as long as
+ *      strings are interned in the same order.
+ */
+typedef uint32_t Intern_Id;
+
+// Never given to a string, so that zeroed memory reads as "no name".
+#define INTERN_ID_NONE  0
+
+/**
+ * @note
+ *      Only 12 bytes ahead of the string, and only aligned to 4 bytes.
+ */
 typedef struct {
-    size_t   len;
-    uint32_t hash;
-    char     data[];
+    uint32_t  len;
+    uint32_t  hash; // The low 32 bits of the full hash.
+    Intern_Id id;
+    char      data[];
 } Intern_String;
 
+/**
+ * @brief
+ *      A SwissTable-style hash set of strings. Besides `entries`, each slot has
+ *      1 control byte in `ctrl`: 0 if empty, else the top bit set and 7 more
+ *      bits of the hash. A lookup compares a whole group of control bytes
+ *      against those 7 bits at once, then only looks at the strings whose
+ *      bits matched: about 1 in 128 of the others.
+ *
+ *      The strings themselves are packed 1 after the other in `chunks`, and
+ *      are only ever freed all at once by `intern_destroy()`. `strings` maps
+ *      each `Intern_Id` back to its string.
+ *
+ *      Growing the table does not move every string at once. The old slots
+ *      stay in `old_entries` while each call to `intern_get` and friends moves
+ *      the next `migrate_step` of them, by id, and lookups check both tables
+ *      until none are left. The new table has room for as many inserts as the
+ *      old one had strings, so this always finishes before it is full.
+ *
+ * @note
+ *      `ctrl` is part of the same allocation as `entries`, right after it.
+ *      The same goes for `old_ctrl` and `old_entries`.
+ */
+typedef struct {
+    Allocator       allocator;
+    Intern_Hash     hash;
+    Intern_Entry   *entries;
+    uint8_t        *ctrl;
+    Intern_Chunk   *chunks;       // String storage, newest first.
+    Intern_String **strings;      // Indexed by `Intern_Id`. `strings[0]` is unused.
+    size_t          strings_cap;
+    size_t          count;        // Also the last id given out.
+    size_t          cap;          // 0, or a power of 2 no less than `INTERN_GROUP_WIDTH`.
+    int             max_probe;    // Most groups any string had to look past.
+    Intern_Entry   *old_entries;  // `NULL` unless strings are still being moved out of it.
+    uint8_t        *old_ctrl;
+    size_t          old_cap;
+    int             old_max_probe;
+    size_t          old_count;    // Ids up to this one were in `old_entries`...
+    size_t          migrated;     // ...and up to this one have been moved to `entries`.
+    size_t          migrate_step; // Strings moved per call. 0 moves them all at once, as they used to be.
+} Intern;
+
 /**
  * @brief
  *      Create a new stack-allocated `Intern` instance with the given allocator.
@@ -39,6 +120,39 @@ typedef struct {
 Intern
 intern_make(Allocator allocator);
 
+/**
+ * @brief
+ *      The same as `intern_make`, but keys are hashed with `hash` rather than
+ *      `intern_hash_wide`.
+ */
+Intern
+intern_make_with_hash(Allocator allocator, Intern_Hash hash);
+
+/**
+ * @brief
+ *      Get the hash function for `kind`. For `Intern_Hash_Kind_CRC32C`, this
+ *      asks `cpuid` whether the `crc32` instruction is there.
+ */
+Intern_Hash
+intern_hash_get(Intern_Hash_Kind kind);
+
+/**
+ * @brief
+ *      Reads 8 bytes at a time and mixes them with a 64x64 to 128-bit
+ *      multiply, in the spirit of wyhash. Keys over 48 bytes are spread over
+ *      3 independent lanes so the multiplies can overlap.
+ */
+uint64_t
+intern_hash_wide(String text);
+
+/**
+ * @brief
+ *      64-bit FNV-1a, 1 byte at a time. Slow for long keys, but portable and
+ *      simple.
+ */
+uint64_t
+intern_hash_fnv1a(String text);
+
 /**
  * @brief
  *      Deallocates all the memory associated with `intern`.
@@ -53,7 +167,8 @@ intern_destroy(Intern *intern);
  *
  * @return
  *      A `String` instance which points to the underlying `Intern_String`.
- *      This string is valid as long as the map lives.
+ *      This string is valid as long as the map lives. If `text` had to be
+ *      interned but that ran out of memory, `data` is `NULL`.
  */
 String
 intern_get(Intern *intern, String text);
@@ -71,6 +186,27 @@ intern_get(Intern *intern, String text);
 const char *
 intern_get_cstring(Intern *intern, String text);
 
+/**
+ * @brief
+ *      Same semantics as `intern_get`, but returns the id of `text`.
+ *
+ * @return
+ *      `INTERN_ID_NONE` if `text` had to be interned but that ran out of memory.
+ */
+Intern_Id
+intern_get_id(Intern *intern, String text);
+
+/**
+ * @brief
+ *      Get the string for `id` in O(1): 1 array index, no hashing. `id` must
+ *      have come from `intern`.
+ *
+ * @return
+ *      The interned, nul-terminated string or, for `INTERN_ID_NONE`, `{NULL, 0}`.
+ */
+String
+intern_lookup_id(const Intern *intern, Intern_Id id);
+
 /**
  * @note
  *      Same semantics as `intern_get` and `intern_get_cstring`.
@@ -83,58 +219,220 @@ intern_get_cstring(Intern *intern, String text);
 const Intern_String *
 intern_get_interned(Intern *intern, String text);
 
+/**
+ * @brief
+ *      Look for `text` without interning it. Nothing is inserted or allocated,
+ *      so this is safe for checking whether a name exists at all.
+ *
+ * @note
+ *      A miss gives up at the first group of slots with an empty 1 in it, or
+ *      after `max_probe` groups, whichever comes first.
+ *
+ * @return
+ *      The interned string or `NULL` if `text` was never interned.
+ */
+const Intern_String *
+intern_find(const Intern *intern, String text);
+
+#ifdef __SSE2__
+#define INTERN_GROUP_WIDTH  16
+#else // __SSE2__
+#define INTERN_GROUP_WIDTH  8
+#endif // __SSE2__
+
 #ifdef DSA_INTERN_IMPLEMENTATION
 
 #include <string.h> // memcmp, memcpy (likely highly optimized)
 #include <stdio.h>  // fprintf
 
 struct Intern_Entry {
-    Intern_String *value;
-    int            probe; // Our distance from our ideal position `hash % cap`.
+    // Rather than an `Intern_Id`, which would cost a hit 1 more cache miss on
+    // `strings` before it could compare anything.
+    Intern_String *value; // Only meaningful if the control byte says the slot is full.
+};
+
+struct Intern_Chunk {
+    Intern_Chunk *prev;
+    size_t        used; // The current number of bytes used in `base`.
+    size_t        size; // The total number of bytes in `base`.
+    alignas(Intern_String) char base[];
 };
 
+// `Intern_String` only keeps 32 bits of hash. Less the 7 bits of the control
+// byte, that places it in up to this many slots without hashing it again.
+#define INTERN_STORED_HASH_MAX_CAP  (cast(size_t)1 << 25)
+
+// Control bytes of full slots have this bit set, so that an empty one (0)
+// never matches.
+#define INTERN_CTRL_FULL    0x80
+
+//=== GROUPS =============================================================== {{{
+
+/**
+ * @brief
+ *      `INTERN_GROUP_WIDTH` control bytes, compared all at once. Matches come
+ *      back as a bit mask with 1 bit (or byte) per slot, lowest slot first.
+ */
+#if INTERN_GROUP_WIDTH == 16
+
+#include <emmintrin.h> // SSE2
+
+typedef __m128i  Intern_Group;
+typedef uint32_t Intern_Mask;
+
+static inline Intern_Group
+_intern_group_load(const uint8_t *ctrl)
+{
+    return _mm_loadu_si128(cast(const __m128i *)ctrl);
+}
+
+static inline Intern_Mask
+_intern_group_match(Intern_Group group, uint8_t ctrl)
+{
+    return cast(Intern_Mask)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(cast(char)ctrl)));
+}
+
+static inline Intern_Mask
+_intern_group_match_empty(Intern_Group group)
+{
+    return cast(Intern_Mask)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_setzero_si128()));
+}
+
+static inline size_t
+_intern_mask_first(Intern_Mask mask)
+{
+    return cast(size_t)__builtin_ctz(mask);
+}
+
+#else // INTERN_GROUP_WIDTH == 16
+
+// Portable fallback: 8 control bytes in a `uint64_t`, with the result in the
+// top bit of each byte.
+typedef uint64_t Intern_Group;
+typedef uint64_t Intern_Mask;
+
+#define INTERN_GROUP_LSB    0x0101010101010101ULL
+#define INTERN_GROUP_MSB    0x8080808080808080ULL
+
+static inline Intern_Group
+_intern_group_load(const uint8_t *ctrl)
+{
+    Intern_Group group;
+    memcpy(&group, ctrl, sizeof(group));
+    return group;
+}
+
+/**
+ * @note
+ *      May report a false match right after a true one. That is fine, we
+ *      compare the whole hash next anyway.
+ */
+static inline Intern_Mask
+_intern_group_match(Intern_Group group, uint8_t ctrl)
+{
+    uint64_t x = group ^ (INTERN_GROUP_LSB * ctrl);
+    return (x - INTERN_GROUP_LSB) & ~x & INTERN_GROUP_MSB;
+}
+
+static inline Intern_Mask
+_intern_group_match_empty(Intern_Group group)
+{
+    // Exact, as every other control byte has its top bit set.
+    return (group - INTERN_GROUP_LSB) & ~group & INTERN_GROUP_MSB;
+}
+
+static inline size_t
+_intern_mask_first(Intern_Mask mask)
+{
+    return cast(size_t)__builtin_ctzll(mask) >> 3;
+}
+
+#endif // INTERN_GROUP_WIDTH == 16
+
+//=== }}} ======================================================================
+
 Intern
 intern_make(Allocator allocator)
+{
+    return intern_make_with_hash(allocator, &intern_hash_wide);
+}
+
+Intern
+intern_make_with_hash(Allocator allocator, Intern_Hash hash)
 {
     Intern intern = {
-        .allocator = allocator,
-        .entries   = NULL,
-        .count     = 0,
-        .cap       = 0,
-        .max_probe = 0,
+        .allocator     = allocator,
+        .hash          = hash,
+        .entries       = NULL,
+        .ctrl          = NULL,
+        .chunks        = NULL,
+        .strings       = NULL,
+        .strings_cap   = 0,
+        .count         = 0,
+        .cap           = 0,
+        .max_probe     = 0,
+        .old_entries   = NULL,
+        .old_ctrl      = NULL,
+        .old_cap       = 0,
+        .old_max_probe = 0,
+        .old_count     = 0,
+        .migrated      = 0,
+        .migrate_step  = INTERN_MIGRATE_STEP,
     };
     return intern;
 }
 
+static size_t
+_intern_table_size(size_t cap)
+{
+    // The first `INTERN_GROUP_WIDTH - 1` control bytes are repeated at the
+    // end, so a group can be loaded starting from any slot.
+    return cap * sizeof(Intern_Entry) + cap + INTERN_GROUP_WIDTH;
+}
+
 void
 intern_destroy(Intern *intern)
 {
-    Allocator     allocator = intern->allocator;
-    Intern_Entry *entries   = intern->entries;
-    const size_t  cap       = intern->cap;
+    Allocator allocator = intern->allocator;
 
-    for (size_t i = 0; i < cap; ++i) {
-        Intern_String *value = entries[i].value;
-        if (value == NULL)
-            continue;
-
-        mem_rawfree(value, sizeof(*value) + (value->len + 1), allocator);
+    // Strings are never freed 1 by 1, only whole chunks at a time.
+    for (Intern_Chunk *chunk = intern->chunks, *prev; chunk != NULL; chunk = prev) {
+        prev = chunk->prev;
+        mem_rawfree(chunk, sizeof(*chunk) + chunk->size, allocator);
     }
-    mem_delete(entries, cap, allocator);
-    intern->entries = NULL;
-    intern->count   = 0;
-    intern->cap     = 0;
+    if (intern->entries != NULL)
+        mem_rawfree(intern->entries, _intern_table_size(intern->cap), allocator);
+    if (intern->old_entries != NULL)
+        mem_rawfree(intern->old_entries, _intern_table_size(intern->old_cap), allocator);
+    if (intern->strings != NULL)
+        mem_delete(intern->strings, intern->strings_cap, allocator);
+    intern->entries       = NULL;
+    intern->ctrl          = NULL;
+    intern->chunks        = NULL;
+    intern->strings       = NULL;
+    intern->strings_cap   = 0;
+    intern->count         = 0;
+    intern->cap           = 0;
+    intern->max_probe     = 0;
+    intern->old_entries   = NULL;
+    intern->old_ctrl      = NULL;
+    intern->old_cap       = 0;
+    intern->old_max_probe = 0;
+    intern->old_count     = 0;
+    intern->migrated      = 0;
 }
 
-#define FNV_OFFSET  2166136261
-#define FNV_PRIME   16777619
+//=== HASHING ============================================================== {{{
+
+#define FNV_OFFSET  14695981039346656037ULL
+#define FNV_PRIME   1099511628211ULL
 
-static uint32_t
-_intern_hash(String data)
+uint64_t
+intern_hash_fnv1a(String text)
 {
-    uint32_t hash = FNV_OFFSET;
-    string_for_each(byte, data) {
-        // Can't cast the expression to `uint32_t`? Is this not defined behavior?
+    uint64_t hash = FNV_OFFSET;
+    string_for_each(byte, text) {
+        // Can't cast the expression to `uint64_t`? Is this not defined behavior?
         hash ^= cast(unsigned char)byte;
         hash *= FNV_PRIME;
     }
@@ -145,34 +443,288 @@ _intern_hash(String data)
 #undef FNV_OFFSET
 #undef FNV_PRIME
 
-// We pass `entries` directly in the case of `_intern_resize()`.
-static Intern_Entry *
-_intern_get(Intern_Entry entries[], size_t cap, String string, uint32_t hash, int *probe)
+// Odd constants with about as many 1 bits as 0 bits, from wyhash.
+#define WIDE_SECRET0    0xa0761d6478bd642fULL
+#define WIDE_SECRET1    0xe7037ed1a0b428dbULL
+#define WIDE_SECRET2    0x8ebc6af09c88c6e3ULL
+#define WIDE_SECRET3    0x589965cc75374cc3ULL
+
+// `memcpy` compiles down to a single unaligned load.
+static inline uint64_t
+_intern_read8(const char *ptr)
 {
-    // Division (and by extension, modulo) by zero is undefined behavior.
-    if (cap == 0)
-        return NULL;
+    uint64_t word;
+    memcpy(&word, ptr, sizeof(word));
+    return word;
+}
 
-    // Micro-optimization to avoid constant pointer dereferences.
-    int _probe = 0;
-    for (size_t i = cast(size_t)hash % cap; /* empty */; ++_probe, i = (i + 1) % cap) {
-        Intern_String *istring = entries[i].value;
+static inline uint64_t
+_intern_read4(const char *ptr)
+{
+    uint32_t word;
+    memcpy(&word, ptr, sizeof(word));
+    return word;
+}
 
-        // This string isn't interned yet.
-        if (istring == NULL)
-            goto set_result;
+/**
+ * @brief
+ *      Multiply `a` and `b` into 128 bits and fold the halves together.
+ */
+static inline uint64_t
+_intern_mix(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = cast(__uint128_t)a * b;
+    return cast(uint64_t)product ^ cast(uint64_t)(product >> 64);
+#else // __SIZEOF_INT128__
+    uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    uint64_t lo    = (cross << 32) | (lo_lo & 0xFFFFFFFF);
+    uint64_t hi    = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    return lo ^ hi;
+#endif // __SIZEOF_INT128__
+}
 
-        // Probably not a match. Keep looking.
-        if (istring->hash != hash || istring->len != string.len)
-            continue;
+uint64_t
+intern_hash_wide(String text)
+{
+    const char *ptr  = text.data;
+    size_t      len  = text.len;
+    uint64_t    seed = WIDE_SECRET0;
+    uint64_t    a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            // 2 pairs of 4-byte reads, overlapping as needed, cover 4 to 16.
+            size_t step = (len >> 3) << 2;
+            a = (_intern_read4(ptr) << 32) | _intern_read4(ptr + step);
+            b = (_intern_read4(ptr + len - 4) << 32) | _intern_read4(ptr + len - 4 - step);
+        } else if (len > 0) {
+            a = (cast(uint64_t)cast(unsigned char)ptr[0] << 16)
+              | (cast(uint64_t)cast(unsigned char)ptr[len >> 1] << 8)
+              | cast(uint64_t)cast(unsigned char)ptr[len - 1];
+            b = 0;
+        } else {
+            a = 0;
+            b = 0;
+        }
+    } else {
+        size_t left = len;
+        if (left > 48) {
+            uint64_t lane1 = seed;
+            uint64_t lane2 = seed;
+            do {
+                seed  = _intern_mix(_intern_read8(ptr)      ^ WIDE_SECRET1, _intern_read8(ptr + 8)  ^ seed);
+                lane1 = _intern_mix(_intern_read8(ptr + 16) ^ WIDE_SECRET2, _intern_read8(ptr + 24) ^ lane1);
+                lane2 = _intern_mix(_intern_read8(ptr + 32) ^ WIDE_SECRET3, _intern_read8(ptr + 40) ^ lane2);
+                ptr  += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while (left > 16) {
+            seed  = _intern_mix(_intern_read8(ptr) ^ WIDE_SECRET1, _intern_read8(ptr + 8) ^ seed);
+            ptr  += 16;
+            left -= 16;
+        }
+        // The last 16 bytes, overlapping what we already did if need be.
+        a = _intern_read8(ptr + left - 16);
+        b = _intern_read8(ptr + left - 8);
+    }
+    return _intern_mix(WIDE_SECRET1 ^ cast(uint64_t)len, _intern_mix(a ^ WIDE_SECRET1, b ^ seed));
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
 
-        // Confirm if it is indeed a match.
-        if (memcmp(string.data, istring->data, istring->len) == 0) set_result: {
+#include <cpuid.h>     // __get_cpuid, bit_SSE4_2
+#include <nmmintrin.h> // _mm_crc32_u64
+
+/**
+ * @brief
+ *      2 CRC32C lanes over alternating words, so that each `crc32` (3 cycles
+ *      of latency) overlaps with the other. A CRC is linear, so the 2 lanes
+ *      are joined with `_intern_mix` to spread them over all 64 bits.
+ */
+__attribute__((target("sse4.2")))
+static uint64_t
+_intern_hash_crc32c(String text)
+{
+    const char *ptr  = text.data;
+    size_t      left = text.len;
+    uint64_t    a    = 0xFFFFFFFF;
+    uint64_t    b    = 0x7A3C1B5E;
+    for (; left >= 16; ptr += 16, left -= 16) {
+        a = _mm_crc32_u64(a, _intern_read8(ptr));
+        b = _mm_crc32_u64(b, _intern_read8(ptr + 8));
+    }
+    if (left >= 8) {
+        a     = _mm_crc32_u64(a, _intern_read8(ptr));
+        ptr  += 8;
+        left -= 8;
+    }
+    if (left > 0) {
+        // Overlapping reads, as in `intern_hash_wide`, rather than a `memcpy`
+        // of variable length. The length goes in at the end.
+        uint64_t tail;
+        if (left >= 4)
+            tail = (_intern_read4(ptr + left - 4) << 32) | _intern_read4(ptr);
+        else
+            tail = (cast(uint64_t)cast(unsigned char)ptr[0] << 16)
+                 | (cast(uint64_t)cast(unsigned char)ptr[left >> 1] << 8)
+                 | cast(uint64_t)cast(unsigned char)ptr[left - 1];
+        b = _mm_crc32_u64(b, tail);
+    }
+    return _intern_mix((a << 32 | b) ^ WIDE_SECRET0, WIDE_SECRET1 ^ cast(uint64_t)text.len);
+}
+
+static bool
+_intern_has_crc32c(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2);
+}
+
+#endif // __x86_64__
+
+#undef WIDE_SECRET0
+#undef WIDE_SECRET1
+#undef WIDE_SECRET2
+#undef WIDE_SECRET3
+
+Intern_Hash
+intern_hash_get(Intern_Hash_Kind kind)
+{
+    switch (kind) {
+    case Intern_Hash_Kind_Wide:
+        return &intern_hash_wide;
+    case Intern_Hash_Kind_CRC32C:
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        if (_intern_has_crc32c())
+            return &_intern_hash_crc32c;
+#endif // __x86_64__
+        return &intern_hash_fnv1a;
+    case Intern_Hash_Kind_FNV1A:
+        return &intern_hash_fnv1a;
+    }
+    assert(false);
+    return &intern_hash_wide;
+}
+
+//=== }}} ======================================================================
+
+static inline uint8_t
+_intern_ctrl_of(uint64_t hash)
+{
+    return cast(uint8_t)(INTERN_CTRL_FULL | (hash & 0x7F));
+}
+
+static inline bool
+_intern_matches(const Intern_String *istring, String text, uint64_t hash)
+{
+    return istring->hash == cast(uint32_t)hash && istring->len == text.len && memcmp(text.data, istring->data, text.len) == 0;
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Look for `text` among the `cap`
+ *      slots of `entries`, 1 group at a time, starting from those picked by
+ *      `hash`.
+ *
+ * @return
+ *      The index of the slot holding `text`, in which case `*found` is set.
+ *      Otherwise, the index of the first empty slot along the way, where
+ *      `text` belongs. `cap` must not be 0.
+ */
+static size_t
+_intern_probe(const Intern_Entry *entries, const uint8_t *ctrl, size_t cap, String text, uint64_t hash, bool *found, int *probe)
+{
+    const size_t  mask = cap - 1;
+    const uint8_t want = _intern_ctrl_of(hash);
+
+    // Triangular steps of whole groups visit every slot when `cap` is a
+    // power of 2.
+    size_t pos  = cast(size_t)(hash >> 7) & mask;
+    size_t step = 0;
+    for (int _probe = 0; /* empty */; ++_probe) {
+        Intern_Group group = _intern_group_load(&ctrl[pos]);
+        for (Intern_Mask match = _intern_group_match(group, want); match != 0; match &= match - 1) {
+            size_t i = (pos + _intern_mask_first(match)) & mask;
+            if (_intern_matches(entries[i].value, text, hash)) {
+                *found = true;
+                *probe = _probe;
+                return i;
+            }
+        }
+
+        // An empty slot means `text` would have gone there, or earlier.
+        Intern_Mask empty = _intern_group_match_empty(group);
+        if (empty != 0) {
+            *found = false;
             *probe = _probe;
-            return &entries[i];
+            return (pos + _intern_mask_first(empty)) & mask;
         }
+        step += INTERN_GROUP_WIDTH;
+        pos   = (pos + step) & mask;
     }
-    __builtin_unreachable();
+}
+
+/**
+ * @brief
+ *      Internal implementation function. The same as `_intern_probe`, but
+ *      only for strings that are there: no string in `entries` is more than
+ *      `max_probe` groups away from where it started, so neither is `text`.
+ *
+ * @return
+ *      The string equal to `text`, or `NULL` if there is none.
+ */
+static Intern_String *
+_intern_probe_existing(const Intern_Entry *entries, const uint8_t *ctrl, size_t cap, int max_probe, String text, uint64_t hash)
+{
+    const size_t  mask = cap - 1;
+    const uint8_t want = _intern_ctrl_of(hash);
+
+    size_t pos  = cast(size_t)(hash >> 7) & mask;
+    size_t step = 0;
+    for (int probe = 0; probe <= max_probe; ++probe) {
+        Intern_Group group = _intern_group_load(&ctrl[pos]);
+        for (Intern_Mask match = _intern_group_match(group, want); match != 0; match &= match - 1) {
+            size_t i = (pos + _intern_mask_first(match)) & mask;
+            if (_intern_matches(entries[i].value, text, hash))
+                return entries[i].value;
+        }
+        if (_intern_group_match_empty(group) != 0)
+            return NULL;
+        step += INTERN_GROUP_WIDTH;
+        pos   = (pos + step) & mask;
+    }
+    return NULL;
+}
+
+/**
+ * @brief
+ *      Internal implementation function. `_intern_probe` in the current table.
+ */
+static size_t
+_intern_find_slot(const Intern *intern, String text, uint64_t hash, bool *found, int *probe)
+{
+    return _intern_probe(intern->entries, intern->ctrl, intern->cap, text, hash, found, probe);
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Fill the empty slot `i` with `value`.
+ */
+static void
+_intern_fill_slot(Intern *intern, size_t i, Intern_String *value)
+{
+    uint8_t ctrl = _intern_ctrl_of(value->hash);
+    intern->entries[i].value = value;
+    intern->ctrl[i]          = ctrl;
+    // Keep the copy at the end in sync.
+    if (i < INTERN_GROUP_WIDTH - 1)
+        intern->ctrl[intern->cap + i] = ctrl;
 }
 
 static void
@@ -182,119 +734,215 @@ _intern_update_max_probe(Intern *intern, int probe)
         intern->max_probe = probe;
 }
 
+/**
+ * @brief
+ *      Internal implementation function. Get enough of the hash of `istring`
+ *      to place it in `intern->cap` slots.
+ */
+static uint64_t
+_intern_rehash(const Intern *intern, const Intern_String *istring)
+{
+    if (intern->cap <= INTERN_STORED_HASH_MAX_CAP)
+        return istring->hash;
+    String key = {istring->data, istring->len};
+    return intern->hash(key);
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Move up to `step` more strings out
+ *      of `old_entries`, or all of them if `step` is 0. Frees the old table
+ *      once it is empty.
+ */
+static void
+_intern_migrate(Intern *intern, size_t step)
+{
+    size_t end = intern->old_count;
+    if (step != 0 && end - intern->migrated > step)
+        end = intern->migrated + step;
+
+    // `strings` has every id in order, so there is no need to scan the old
+    // slots for them.
+    for (size_t id = intern->migrated + 1; id <= end; ++id) {
+        // All strings are distinct, so this only ever finds an empty slot.
+        bool           found;
+        int            probe;
+        Intern_String *interned = intern->strings[id];
+        String         key      = {interned->data, interned->len};
+        size_t         slot     = _intern_find_slot(intern, key, _intern_rehash(intern, interned), &found, &probe);
+        _intern_fill_slot(intern, slot, interned);
+        _intern_update_max_probe(intern, probe);
+    }
+    intern->migrated = end;
+
+    if (end == intern->old_count && intern->old_entries != NULL) {
+        mem_rawfree(intern->old_entries, _intern_table_size(intern->old_cap), intern->allocator);
+        intern->old_entries = NULL;
+        intern->old_ctrl    = NULL;
+        intern->old_cap     = 0;
+    }
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Start moving to a table of `new_cap`
+ *      slots. Any earlier move must be done.
+ */
 static Allocator_Error
 _intern_resize(Intern *intern, size_t new_cap)
 {
-    Allocator       allocator   = intern->allocator;
+    assert(intern->old_entries == NULL);
     Allocator_Error error;
-    Intern_Entry   *new_entries = mem_make(Intern_Entry, &error, new_cap, allocator);
+    // Zeroed, since a control byte of 0 is an empty slot. Big tables are
+    // often zero already, straight from the OS.
+    void *table = mem_rawnew_zeroed(&error, _intern_table_size(new_cap), alignof(Intern_Entry), intern->allocator, SOURCE_LOCATION);
     if (error)
         return error;
 
-    // Zero out the new memory so that we can safely read them.
-    memset(new_entries, 0, sizeof(new_entries[0]) * new_cap);
-
-    // Copy the old non-empty entries.
-    size_t        new_count   = 0;
-    Intern_Entry *old_entries = intern->entries;
-    size_t        old_cap     = intern->cap;
+    intern->old_entries   = intern->entries;
+    intern->old_ctrl      = intern->ctrl;
+    intern->old_cap       = intern->cap;
+    intern->old_max_probe = intern->max_probe;
+    intern->old_count     = intern->count;
+    intern->migrated      = 0;
+    intern->entries       = cast(Intern_Entry *)table;
+    intern->ctrl          = cast(uint8_t *)&intern->entries[new_cap];
+    intern->cap           = new_cap;
+    intern->max_probe     = 0;
+    _intern_migrate(intern, intern->migrate_step);
+    return error;
+}
 
-    intern->max_probe = 0;
-    for (size_t i = 0; i < old_cap; ++i) {
-        // Ignore unset keys; these are yet to be interned.
-        if (old_entries[i].value == NULL)
-            continue;
+// e.g: 3 / 4 == 75%, 7 / 8 == 87.5%, 9 / 10 == 90%. Matching a whole group at
+// once keeps probes short even when the table is quite full.
+#define LF_NUMERATOR    7
+#define LF_DENOMINATOR  8
 
-        int            probe;
-        Intern_String *interned  = old_entries[i].value;
-        String         key       = {interned->data, interned->len};
-        Intern_Entry  *new_entry = _intern_get(new_entries, new_cap, key, interned->hash, &probe);
+/**
+ * @brief
+ *      Internal implementation function. Bump `size` bytes off of the newest
+ *      chunk, or start a new one.
+ */
+static Intern_String *
+_intern_chunk_alloc(Intern *intern, size_t size)
+{
+    const size_t align = alignof(Intern_String);
+    size = (size + align - 1) & ~(align - 1);
+
+    Intern_Chunk *chunk = intern->chunks;
+    if (chunk != NULL && chunk->size - chunk->used >= size) {
+        Intern_String *value = cast(Intern_String *)&chunk->base[chunk->used];
+        chunk->used += size;
+        return value;
+    }
 
-        // Probe may be different now that we've resized the hash table.
-        *new_entry       = old_entries[i];
-        new_entry->probe = probe;
-        ++new_count;
+    // Whatever is left at the end of `chunk` is abandoned.
+    size_t want = (chunk == NULL) ? INTERN_CHUNK_SIZE : 2 * (sizeof(*chunk) + chunk->size);
+    if (want > INTERN_CHUNK_MAX_SIZE)
+        want = INTERN_CHUNK_MAX_SIZE;
+    bool dedicated = sizeof(*chunk) + size > want;
+    if (dedicated)
+        want = sizeof(*chunk) + size;
 
-        _intern_update_max_probe(intern, probe);
+    // Take all of the slack the allocator has to give.
+    Allocator_Error error;
+    size_t          got;
+    Intern_Chunk   *new_chunk = cast(Intern_Chunk *)mem_rawnew_sized(&error, want, alignof(Intern_Chunk), intern->allocator, &got, SOURCE_LOCATION);
+    if (error)
+        return NULL;
+    new_chunk->used = size;
+    new_chunk->size = got - sizeof(*new_chunk);
+
+    // A dedicated chunk goes behind the newest one, which may still have room.
+    if (dedicated && chunk != NULL) {
+        new_chunk->prev = chunk->prev;
+        chunk->prev     = new_chunk;
+    } else {
+        new_chunk->prev = chunk;
+        intern->chunks  = new_chunk;
     }
-
-    mem_delete(old_entries, old_cap, allocator);
-    intern->entries = new_entries;
-    intern->count   = new_count;
-    intern->cap     = new_cap;
-    return error;
+    return cast(Intern_String *)new_chunk->base;
 }
 
-static void
-_intern_swap_entries(Intern_Entry *restrict a, Intern_Entry *restrict b)
+/**
+ * @brief
+ *      Internal implementation function. Make room in `strings` for 1 more id.
+ */
+static Allocator_Error
+_intern_reserve_id(Intern *intern)
 {
-    Intern_Entry tmp = *a;
-    *a = *b;
-    *b = tmp;
-}
+    if (intern->count + 1 < intern->strings_cap)
+        return Allocator_Error_None;
 
-// e.g: 3 / 4 == 75%, 4 / 5 == 80%, 9 / 10 == 90%
-#define LF_NUMERATOR    3
-#define LF_DENOMINATOR  4
+    // The heap allocator grows large enough arrays with `mremap`, no copying.
+    Allocator_Error error;
+    size_t          old_size = intern->strings_cap * sizeof(intern->strings[0]);
+    size_t          new_size = (old_size == 0) ? 64 * sizeof(intern->strings[0]) : 2 * old_size;
+    size_t          got;
+    Intern_String **strings  = cast(Intern_String **)mem_rawresize_sized(&error, intern->strings, old_size, new_size,
+        alignof(Intern_String *), intern->allocator, &got, SOURCE_LOCATION);
+    if (error)
+        return error;
+    strings[INTERN_ID_NONE] = NULL;
+    intern->strings         = strings;
+    intern->strings_cap     = got / sizeof(strings[0]);
+    return Allocator_Error_None;
+}
 
+/**
+ * @brief
+ *      Internal implementation function. Intern `text`, which was not found.
+ *      `slot` and `probe` are where `_intern_find_slot` would have put it.
+ */
 static Intern_String *
-_intern_set(Intern *intern, String text, uint32_t hash)
+_intern_set(Intern *intern, String text, uint64_t hash, size_t slot, int probe)
 {
-    size_t cap = intern->cap;
+    bool found;
+    if (text.len > UINT32_MAX || intern->count >= UINT32_MAX)
+        return NULL;
+    if (_intern_reserve_id(intern))
+        return NULL;
 
-    // Adjust by 0.75 load factor but using pure integer math.
+    // Adjust by 0.875 load factor but using pure integer math.
     // We do this to ensure there are always empty slots.
-    if (intern->count >= (cap * LF_NUMERATOR) / LF_DENOMINATOR) {
+    if (intern->count >= (intern->cap * LF_NUMERATOR) / LF_DENOMINATOR) {
         // Always the next power of 2. Unlike dynamic arrays, we always want a
         // new and unique block of memory before we replace the current one.
-        size_t new_cap = (cap == 0) ? 1 << 3 : cap << 1;
-        _intern_resize(intern, new_cap);
-        cap = new_cap;
+        size_t new_cap = (intern->cap == 0) ? 2 * INTERN_GROUP_WIDTH : intern->cap << 1;
+        // Only if `migrate_step` was changed halfway through a move.
+        if (intern->old_entries != NULL)
+            _intern_migrate(intern, 0);
+        Allocator_Error error = _intern_resize(intern, new_cap);
+        if (error)
+            return NULL;
+        slot = _intern_find_slot(intern, text, hash, &found, &probe);
     }
 
-    Allocator_Error error;
     // Add 1 for nul terminator.
-    Intern_String *value = cast(Intern_String *)mem_rawnew(
-        &error,
-        sizeof(*value) + sizeof(value->data[0]) * (text.len + 1),
-        alignof(Intern_String), // alignof(*value) is an extension MSVC doesn't have
-        intern->allocator
-    );
-
-    if (error)
+    Intern_String *value = _intern_chunk_alloc(intern, offsetof(Intern_String, data) + text.len + 1);
+    if (value == NULL)
         return NULL;
 
-    value->len  = text.len;
-    value->hash = hash;
+    value->len  = cast(uint32_t)text.len;
+    value->hash = cast(uint32_t)hash;
     value->data[value->len] = '\0';
     memcpy(value->data, text.data, text.len);
 
-    Intern_Entry  entry   = {.value = value, .probe = 0};
-    Intern_Entry *entries = intern->entries;
-
-    // Yes this is basically copy-pasting `_intern_get()`, but we need to add
-    // the Robin Hood swapping mechanic.
-    for (size_t i = cast(size_t)value->hash % cap; /* empty */; i = (i + 1) % cap) {
-        // We can safely write to this entry without overwriting active (live) data?
-        if (entries[i].value == NULL) {
-            entries[i] = entry;
-            ++intern->count;
-            return value;
-        }
-
-        // Is our current collision "richer" (closer to desired index) than us?
-        if (entries[i].probe < entry.probe)
-            _intern_swap_entries(&entries[i], &entry);
-
-        _intern_update_max_probe(intern, ++entry.probe);
-    }
-    assert(false);
+    value->id = cast(Intern_Id)++intern->count;
+    intern->strings[value->id] = value;
+    _intern_fill_slot(intern, slot, value);
+    _intern_update_max_probe(intern, probe);
+    return value;
 }
 
 String
 intern_get(Intern *intern, String text)
 {
     const Intern_String *interned = intern_get_interned(intern, text);
+    if (interned == NULL) {
+        String empty = {NULL, 0};
+        return empty;
+    }
     String key = {interned->data, interned->len};
     return key;
 }
@@ -303,21 +951,71 @@ const char *
 intern_get_cstring(Intern *intern, String text)
 {
     // Each interned string is already nul-terminated.
-    return intern_get_interned(intern, text)->data;
+    const Intern_String *interned = intern_get_interned(intern, text);
+    return (interned != NULL) ? interned->data : NULL;
 }
 
 const Intern_String *
 intern_get_interned(Intern *intern, String text)
 {
-    uint32_t      hash  = _intern_hash(text);
-    int           probe; // Only needed to avoid NULL checks in `_intern_get()`.
-    Intern_Entry *entry = _intern_get(intern->entries, intern->cap, text, hash, &probe);
+    // Every call pays for a little of the move, hit or miss.
+    if (intern->old_entries != NULL)
+        _intern_migrate(intern, intern->migrate_step);
+
+    uint64_t hash  = intern->hash(text);
+    size_t   slot  = 0;
+    int      probe = 0;
+    if (intern->cap != 0) {
+        bool found;
+        slot = _intern_find_slot(intern, text, hash, &found, &probe);
+        if (found)
+            return intern->entries[slot].value;
+    }
+    if (intern->old_entries != NULL) {
+        Intern_String *interned = _intern_probe_existing(intern->old_entries, intern->old_ctrl, intern->old_cap,
+            intern->old_max_probe, text, hash);
+        if (interned != NULL)
+            return interned;
+    }
 
     // If not yet interned, do so now.
-    if (entry == NULL || entry->value == NULL)
-        return _intern_set(intern, text, hash);
-    else
-        return entry->value;
+    return _intern_set(intern, text, hash, slot, probe);
+}
+
+const Intern_String *
+intern_find(const Intern *intern, String text)
+{
+    if (intern->count == 0)
+        return NULL;
+
+    // Strings still waiting to be moved are only in the old table.
+    uint64_t             hash     = intern->hash(text);
+    const Intern_String *interned = _intern_probe_existing(intern->entries, intern->ctrl, intern->cap,
+        intern->max_probe, text, hash);
+    if (interned == NULL && intern->old_entries != NULL)
+        interned = _intern_probe_existing(intern->old_entries, intern->old_ctrl, intern->old_cap,
+            intern->old_max_probe, text, hash);
+    return interned;
+}
+
+Intern_Id
+intern_get_id(Intern *intern, String text)
+{
+    const Intern_String *interned = intern_get_interned(intern, text);
+    return (interned != NULL) ? interned->id : INTERN_ID_NONE;
+}
+
+String
+intern_lookup_id(const Intern *intern, Intern_Id id)
+{
+    assert(id <= intern->count);
+    if (id == INTERN_ID_NONE) {
+        String empty = {NULL, 0};
+        return empty;
+    }
+    const Intern_String *interned = intern->strings[id];
+    String               key      = {interned->data, interned->len};
+    return key;
 }
 
 #endif // DSA_INTERN_IMPLEMENTATION
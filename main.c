@@ -3,6 +3,10 @@
 
 #include "mem/allocator.h"
 #include "mem/arena.h"
+#include "mem/budget.h"
+#ifdef MAIN_TRACK_MEMORY
+#include "mem/tracking.h"
+#endif // MAIN_TRACK_MEMORY
 #include "intern.h"
 
 #include "types/types.h"
@@ -10,6 +14,26 @@
 /// standard
 #include <string.h>
 
+#ifndef MAIN_MEMORY_LIMIT
+#define MAIN_MEMORY_LIMIT       (cast(size_t)64 << 20)
+#endif // MAIN_MEMORY_LIMIT
+
+// When we get this close to `MAIN_MEMORY_LIMIT`, the spelling cache goes.
+#define MAIN_LOW_WATERMARK      (MAIN_MEMORY_LIMIT / 8)
+
+// Set by `on_low_watermark`. The cache may be in the middle of growing when
+// it is called, so it is cleared between queries instead.
+static bool shed_cache;
+
+static void
+on_low_watermark(Budget_Allocator *budget, size_t used, void *user_ptr)
+{
+    unused(budget);
+    unused(used);
+    unused(user_ptr);
+    shed_cache = true;
+}
+
 static void
 run_interactive(CType_Table *table)
 {
@@ -28,11 +52,17 @@ run_interactive(CType_Table *table)
         if (info != NULL) {
             printfln("Expr : %s : '%s' (%p)",
                 ctype_kind_strings[info->type->kind].data,
-                info->name->data,
+                intern_lookup_id(table->intern, info->name).data,
                 cast(void *)info);
         }
         println("==============\n");
 
+        if (shed_cache) {
+            println("Memory is running low; clearing the type cache.\n");
+            ctype_table_clear_cache(table);
+            shed_cache = false;
+        }
+
         size_t total;
         size_t used  = arena_get_usage(&_global_arena, &total);
         printfln(
@@ -55,14 +85,32 @@ main(void)
     if (global_temp_allocator_init() != Allocator_Error_None)
         return 1;
 
+    // Past the budget, allocations fail cleanly instead of panicking.
+    static Budget_Allocator budget;
+    budget_allocator_init(&budget, global_panic_allocator, MAIN_MEMORY_LIMIT,
+        MAIN_LOW_WATERMARK, &on_low_watermark, NULL);
+
+#ifdef MAIN_TRACK_MEMORY
+    // Static, because the callsite table is a little big for the stack.
+    static Tracking_Allocator tracker;
+    tracking_allocator_init(&tracker, budget_allocator(&budget), true);
 
-    Intern          intern = intern_make(global_panic_allocator);
+    Allocator       allocator = tracking_allocator(&tracker);
+#else // MAIN_TRACK_MEMORY
+    Allocator       allocator = budget_allocator(&budget);
+#endif // MAIN_TRACK_MEMORY
+    Intern          intern    = intern_make(allocator);
     CType_Table     table;
-    Allocator_Error error = ctype_table_init(&table, &intern, global_panic_allocator);
+    Allocator_Error error = ctype_table_init(&table, &intern, allocator);
     if (error)
         return 1;
 
     run_interactive(&table);
+#ifdef MAIN_TRACK_MEMORY
+    println("=== MEMORY ===");
+    tracking_allocator_report(&tracker, stdout);
+    println("==============");
+#endif // MAIN_TRACK_MEMORY
     ctype_table_destroy(&table);
     intern_destroy(&intern);
     global_temp_allocator_destroy();
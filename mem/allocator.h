@@ -7,17 +7,46 @@
 #include "../common.h"
 
 typedef enum {
-    Allocator_Mode_Alloc,
+    Allocator_Mode_Alloc,        // Contents are unspecified.
+    Allocator_Mode_Alloc_Zeroed, // Contents are all zero.
     Allocator_Mode_Resize,
     Allocator_Mode_Free,
     Allocator_Mode_Free_All,
+    Allocator_Mode_Alloc_Many,   // `count` objects of `new_size` bytes each.
+
+    // The same as `Allocator_Mode_Alloc`, for callers who want to say so.
+    Allocator_Mode_Alloc_Non_Zeroed = Allocator_Mode_Alloc,
 } Allocator_Mode;
 
+/**
+ * @brief
+ *      Where an allocation request came from. Like Odin's `#caller_location`,
+ *      the `mem_*` macros fill this in for you. Requests made through the
+ *      plain `mem_raw*` functions have a `file` of `NULL`.
+ */
+typedef struct {
+    const char *file;
+    int         line;
+} Source_Location;
+
+#define SOURCE_LOCATION     (Source_Location){__FILE__, __LINE__}
+
 typedef struct {
-    void  *old_ptr;
-    size_t old_size;
-    size_t new_size;
-    size_t alignment;
+    void           *old_ptr;
+    size_t          old_size;
+    size_t          new_size;
+    size_t          alignment;
+    Source_Location location; // Most allocators ignore this.
+
+    // If non-`NULL`, the caller can make use of the whole allocation. It is
+    // already set to `new_size`; allocators that may hand out more (e.g. malloc
+    // size classes, the rest of an arena block) write the real size here.
+    size_t         *out_size;
+
+    // Only for `Allocator_Mode_Alloc_Many`: fill in `out_ptrs[0..count)`, or
+    // fail without leaking any of them.
+    void          **out_ptrs;
+    size_t          count;
 } Allocator_Args;
 
 // The zero-value `Allocator_Error_None` indicates success while nonzero indicates
@@ -68,7 +97,28 @@ typedef struct {
     void *user_ptr;
 } Allocator;
 
-// A simple wrapper around the `malloc` family.
+#ifndef HEAP_LARGE_THRESHOLD
+// Heap requests of at least this many bytes bypass `malloc` and get pages of
+// their own straight from the OS. Must be bigger than the page size.
+#define HEAP_LARGE_THRESHOLD    (1 << 18)
+#endif // HEAP_LARGE_THRESHOLD
+
+/**
+ * @brief
+ *      A simple wrapper around the `malloc` family.
+ *
+ * @note
+ *      Requests of `HEAP_LARGE_THRESHOLD` bytes or more are page-aligned
+ *      `mmap`s instead, resized with `mremap` where it exists. Growing a big
+ *      buffer then costs in pages remapped rather than bytes copied.
+ *
+ *      Which of the 2 a pointer came from is told by its size, so resizes
+ *      and frees must pass the size it was allocated with (or the usable size
+ *      reported through `out_size`). Every user of `Allocator` already has to.
+ *
+ *      `mremap` needs `_GNU_SOURCE`, which the `Makefile` defines. Without it,
+ *      large objects are still `mmap`ed but moved by copying.
+ */
 extern const Allocator global_heap_allocator;
 
 // Panics when an allocation request cannot be fulfilled.
@@ -140,6 +190,63 @@ mem_rawresize(Allocator_Error *out_error, void *old_ptr, size_t old_size, size_t
 Allocator_Error
 mem_rawfree(void *ptr, size_t size, Allocator allocator);
 
+/**
+ * @brief
+ *      The same as `mem_rawnew`, `mem_rawresize` and `mem_rawfree`, but
+ *      passing `location` on to the allocator. The `mem_*` macros use these.
+ */
+void *
+mem_rawnew_loc(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator, Source_Location location);
+
+void *
+mem_rawresize_loc(Allocator_Error *out_error, void *old_ptr, size_t old_size, size_t new_size, size_t align, Allocator allocator, Source_Location location);
+
+Allocator_Error
+mem_rawfree_loc(void *ptr, size_t size, Allocator allocator, Source_Location location);
+
+/**
+ * @brief
+ *      The same as `mem_rawnew_loc`, but the memory is all zero.
+ *
+ * @note
+ *      Allocators that can get zeroed memory for free (e.g. `calloc`, or pages
+ *      fresh from the OS) implement `Allocator_Mode_Alloc_Zeroed`. For those
+ *      that write `Allocator_Error_Mode_Not_Implemented` instead, we fall back
+ *      to `Allocator_Mode_Alloc` and `memset` it ourselves.
+ */
+void *
+mem_rawnew_zeroed(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator, Source_Location location);
+
+/**
+ * @brief
+ *      Allocate `count` objects of `size` bytes each in 1 call to `allocator`,
+ *      writing them to `out_ptrs`. Either all of them are allocated, or none.
+ *
+ * @note
+ *      Each object is its own allocation: free them 1 by 1 with `mem_free`.
+ *      Allocators that can do better than a loop of `mem_rawnew` (e.g. `Arena`
+ *      bumps once for all of them) implement `Allocator_Mode_Alloc_Many`. For
+ *      the rest, we do the loop here.
+ */
+void
+mem_rawnew_many(Allocator_Error *out_error, void **out_ptrs, size_t count, size_t size, size_t align, Allocator allocator, Source_Location location);
+
+/**
+ * @brief
+ *      The same as `mem_rawnew_loc` and `mem_rawresize_loc`, but also writes
+ *      the usable size of the result, which is at least `size` or `new_size`,
+ *      to `out_size`. Growable buffers can take it as their new capacity and
+ *      skip the next few resizes.
+ *
+ * @note
+ *      From then on, pass the usable size as `old_size` to resize or free it.
+ */
+void *
+mem_rawnew_sized(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator, size_t *out_size, Source_Location location);
+
+void *
+mem_rawresize_sized(Allocator_Error *out_error, void *old_ptr, size_t old_size, size_t new_size, size_t align, Allocator allocator, size_t *out_size, Source_Location location);
+
 /**
  * @brief
  *      Low-level memory deallocation function for the `Allocator` interfaces
@@ -177,11 +284,12 @@ mem_free_all(Allocator allocator);
  *      number of elements.
  */
 #define mem_new(T, out_error, allocator)                                       \
-    cast(T *)mem_rawnew(                                                       \
+    cast(T *)mem_rawnew_loc(                                                   \
         out_error,                                                             \
         sizeof(T),                                                             \
         alignof(T),                                                            \
-        allocator)
+        allocator,                                                             \
+        SOURCE_LOCATION)
 
 /**
  * @brief
@@ -206,10 +314,11 @@ mem_free_all(Allocator allocator);
  * ```
  */
 #define mem_free(ptr, allocator)                                               \
-    mem_rawfree(                                                               \
+    mem_rawfree_loc(                                                           \
         ptr,                                                                   \
         sizeof(*(ptr)),                                                        \
-        allocator)
+        allocator,                                                             \
+        SOURCE_LOCATION)
 
 /**
  * @brief
@@ -226,11 +335,47 @@ mem_free_all(Allocator allocator);
  *      data to know how many elements are being pointed to!
  */
 #define mem_make(T, out_error, count, allocator)                               \
-    cast(T *)mem_rawnew(                                                       \
+    cast(T *)mem_rawnew_loc(                                                   \
         out_error,                                                             \
         sizeof(T) * (count),                                                   \
         alignof(T),                                                            \
-        allocator)
+        allocator,                                                             \
+        SOURCE_LOCATION)
+
+/**
+ * @brief
+ *      `mem_make`, but every element is zero. Prefer this to `mem_make` and
+ *      `memset`: large allocations are often already zeroed by the OS, and
+ *      then their pages are not touched twice.
+ */
+#define mem_make_zeroed(T, out_error, count, allocator)                        \
+    cast(T *)mem_rawnew_zeroed(                                                \
+        out_error,                                                             \
+        sizeof(T) * (count),                                                   \
+        alignof(T),                                                            \
+        allocator,                                                             \
+        SOURCE_LOCATION)
+
+/**
+ * @brief
+ *      `mem_new` for `count` objects at once: `out_ptrs` is a `T *[count]`
+ *      that receives them. E.g.
+ *
+ *  ```c
+ *          CType_Info *infos[64];
+ *          mem_make_many(CType_Info, &error, infos, count_of(infos), allocator);
+ *          if (error) { ... } // None of them were allocated.
+ *  ```
+ */
+#define mem_make_many(T, out_error, out_ptrs, count, allocator)                \
+    mem_rawnew_many(                                                           \
+        out_error,                                                             \
+        cast(void **)(out_ptrs),                                               \
+        count,                                                                 \
+        sizeof(T),                                                             \
+        alignof(T),                                                            \
+        allocator,                                                             \
+        SOURCE_LOCATION)
 
 /**
  * @brief
@@ -246,13 +391,30 @@ mem_free_all(Allocator allocator);
  *      to not be freed. What you do in that situation is up to you.
  */
 #define mem_resize(T, out_error, old_ptr, old_count, new_count, allocator)     \
-    cast(T *)mem_rawresize(                                                    \
+    cast(T *)mem_rawresize_loc(                                                \
+        out_error,                                                             \
+        old_ptr,                                                               \
+        sizeof(T) * (old_count),                                               \
+        sizeof(T) * (new_count),                                               \
+        alignof(T),                                                            \
+        allocator,                                                             \
+        SOURCE_LOCATION)
+
+/**
+ * @brief
+ *      `mem_resize`, but `out_size` receives the usable size in bytes. Divide
+ *      it by `sizeof(T)` to get the usable count.
+ */
+#define mem_resize_sized(T, out_error, old_ptr, old_count, new_count, allocator, out_size) \
+    cast(T *)mem_rawresize_sized(                                              \
         out_error,                                                             \
         old_ptr,                                                               \
         sizeof(T) * (old_count),                                               \
         sizeof(T) * (new_count),                                               \
         alignof(T),                                                            \
-        allocator)
+        allocator,                                                             \
+        out_size,                                                              \
+        SOURCE_LOCATION)
 
 /**
  * @brief
@@ -261,18 +423,165 @@ mem_free_all(Allocator allocator);
  *      `ptr`.
  */
 #define mem_delete(ptr, count, allocator)                                      \
-    mem_rawfree(                                                               \
+    mem_rawfree_loc(                                                           \
         ptr,                                                                   \
         sizeof(*ptr) * count,                                                  \
-        allocator)
+        allocator,                                                             \
+        SOURCE_LOCATION)
 
 #ifdef DSA_ALLOCATOR_IMPLEMENTATION
 
 #include <stdlib.h>
+#include <string.h> // memset
 #include <assert.h>
 
+#ifdef __GLIBC__
+#include <malloc.h> // malloc_usable_size
+#endif // __GLIBC__
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ALLOCATOR_HAS_LARGE_PAGES
+#include <sys/mman.h> // mmap, mremap, munmap
+#include <unistd.h>   // sysconf
+#endif
+
 //=== GLOBAL ALLOCATOR WRAPPERS ============================================ {{{
 
+//=== LARGE OBJECTS ======================================================== {{{
+
+static inline bool
+_global_heap_is_large(size_t size)
+{
+#ifdef ALLOCATOR_HAS_LARGE_PAGES
+    return size >= HEAP_LARGE_THRESHOLD;
+#else // !ALLOCATOR_HAS_LARGE_PAGES
+    unused(size);
+    return false;
+#endif // ALLOCATOR_HAS_LARGE_PAGES
+}
+
+#ifdef ALLOCATOR_HAS_LARGE_PAGES
+
+static inline size_t
+_global_heap_page_round(size_t size)
+{
+    size_t page = cast(size_t)sysconf(_SC_PAGESIZE);
+    return (size + (page - 1)) & ~(page - 1);
+}
+
+// Fresh anonymous pages, so they are already zero.
+static void *
+_global_heap_large_alloc(size_t size)
+{
+    void *data = mmap(NULL, _global_heap_page_round(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (data != MAP_FAILED) ? data : NULL;
+}
+
+static void
+_global_heap_large_free(void *ptr, size_t size)
+{
+    munmap(ptr, _global_heap_page_round(size));
+}
+
+static void *
+_global_heap_large_resize(void *old_ptr, size_t old_size, size_t new_size)
+{
+    size_t old_pages = _global_heap_page_round(old_size);
+    size_t new_pages = _global_heap_page_round(new_size);
+#ifdef MREMAP_MAYMOVE
+    // The kernel moves the page table entries; not a single byte is copied.
+    void *data = mremap(old_ptr, old_pages, new_pages, MREMAP_MAYMOVE);
+    return (data != MAP_FAILED) ? data : NULL;
+#else // !MREMAP_MAYMOVE
+    if (new_pages <= old_pages) {
+        if (new_pages < old_pages)
+            munmap(cast(char *)old_ptr + new_pages, old_pages - new_pages);
+        return old_ptr;
+    }
+    void *data = _global_heap_large_alloc(new_size);
+    if (data != NULL) {
+        memcpy(data, old_ptr, old_size);
+        munmap(old_ptr, old_pages);
+    }
+    return data;
+#endif // MREMAP_MAYMOVE
+}
+
+#else // !ALLOCATOR_HAS_LARGE_PAGES
+
+// Never called: `_global_heap_is_large` is always false.
+#define _global_heap_page_round(size)                   (size)
+#define _global_heap_large_alloc(size)                  malloc(size)
+#define _global_heap_large_free(ptr, size)              free(ptr)
+#define _global_heap_large_resize(ptr, old_size, size)  realloc(ptr, size)
+
+#endif // ALLOCATOR_HAS_LARGE_PAGES
+
+//=== }}} ======================================================================
+
+static void *
+_global_heap_rawresize(void *old_ptr, size_t old_size, size_t new_size)
+{
+    bool was_large = old_ptr != NULL && _global_heap_is_large(old_size);
+    bool is_large  = _global_heap_is_large(new_size);
+    if (!was_large && !is_large)
+        return realloc(old_ptr, new_size);
+    if (was_large && is_large)
+        return _global_heap_large_resize(old_ptr, old_size, new_size);
+
+    // Crossing the threshold: move to the other kind, copying what fits.
+    void *data = is_large ? _global_heap_large_alloc(new_size) : malloc(new_size);
+    if (data == NULL)
+        return NULL;
+    if (old_ptr != NULL) {
+        memcpy(data, old_ptr, (old_size < new_size) ? old_size : new_size);
+        if (was_large)
+            _global_heap_large_free(old_ptr, old_size);
+        else
+            free(old_ptr);
+    }
+    return data;
+}
+
+static void *
+_global_heap_rawalloc_zeroed(size_t size)
+{
+    if (_global_heap_is_large(size))
+        return _global_heap_large_alloc(size);
+    return calloc(1, size);
+}
+
+static void
+_global_heap_rawfree(void *ptr, size_t size)
+{
+    if (ptr != NULL && _global_heap_is_large(size))
+        _global_heap_large_free(ptr, size);
+    else
+        free(ptr);
+}
+
+// Report the size class `malloc` actually gave us where we can ask, or the
+// whole pages of a large object.
+static inline void
+_global_heap_report_size(void *data, Allocator_Args args)
+{
+    if (data == NULL || args.out_size == NULL)
+        return;
+
+    if (_global_heap_is_large(args.new_size)) {
+        *args.out_size = _global_heap_page_round(args.new_size);
+        return;
+    }
+#ifdef __GLIBC__
+    // Never let the caller think a small object is large, or we would later
+    // `munmap` what `malloc` gave us.
+    size_t size = malloc_usable_size(data);
+    if (_global_heap_is_large(size))
+        size = HEAP_LARGE_THRESHOLD - 1;
+    *args.out_size = size;
+#endif // __GLIBC__
+}
+
 static void *
 _global_heap_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
 {
@@ -284,16 +593,28 @@ _global_heap_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_
     case Allocator_Mode_Resize:
         // NOTE: If `realloc` fails, `old_ptr` is not freed.
         // Don't free it here, because the caller might still need it!
-        data = realloc(args.old_ptr, args.new_size);
+        data = _global_heap_rawresize(args.old_ptr, args.old_size, args.new_size);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        _global_heap_report_size(data, args);
+        break;
+
+    case Allocator_Mode_Alloc_Zeroed:
+        // `calloc` knows when its memory came straight from the OS, and
+        // large objects always do.
+        data = _global_heap_rawalloc_zeroed(args.new_size);
         if (data == NULL)
             *out_error = Allocator_Error_Out_Of_Memory;
+        _global_heap_report_size(data, args);
         break;
 
     case Allocator_Mode_Free:
-        free(args.old_ptr);
+        _global_heap_rawfree(args.old_ptr, args.old_size);
         break;
 
+    // `malloc` has no batch interface, so there is nothing to gain here.
     case Allocator_Mode_Free_All:
+    case Allocator_Mode_Alloc_Many:
         *out_error = Allocator_Error_Mode_Not_Implemented;
         break;
 
@@ -312,13 +633,20 @@ _global_panic_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator
     switch (mode) {
     case Allocator_Mode_Alloc:
     case Allocator_Mode_Resize:
-        data = realloc(args.old_ptr, args.new_size);
+        data = _global_heap_rawresize(args.old_ptr, args.old_size, args.new_size);
+        assert(data != NULL);
+        _global_heap_report_size(data, args);
+        break;
+    case Allocator_Mode_Alloc_Zeroed:
+        data = _global_heap_rawalloc_zeroed(args.new_size);
         assert(data != NULL);
+        _global_heap_report_size(data, args);
         break;
     case Allocator_Mode_Free:
-        free(args.old_ptr);
+        _global_heap_rawfree(args.old_ptr, args.old_size);
         break;
     case Allocator_Mode_Free_All:
+    case Allocator_Mode_Alloc_Many:
         *out_error = Allocator_Error_Mode_Not_Implemented;
         break;
     default:
@@ -335,9 +663,11 @@ _global_none_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_
     unused(args);
     switch (mode) {
     case Allocator_Mode_Alloc:
+    case Allocator_Mode_Alloc_Zeroed:
     case Allocator_Mode_Resize:
     case Allocator_Mode_Free:
     case Allocator_Mode_Free_All:
+    case Allocator_Mode_Alloc_Many:
         break;
     default:
         assert(false);
@@ -362,40 +692,160 @@ mem_free_all(Allocator allocator)
 
 void *
 mem_rawnew(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator)
+{
+    return mem_rawnew_loc(out_error, size, align, allocator, (Source_Location){NULL, 0});
+}
+
+void *
+mem_rawresize(Allocator_Error *out_error, void *old_ptr, size_t old_size, size_t new_size, size_t align, Allocator allocator)
+{
+    return mem_rawresize_loc(out_error, old_ptr, old_size, new_size, align, allocator, (Source_Location){NULL, 0});
+}
+
+Allocator_Error
+mem_rawfree(void *ptr, size_t size, Allocator allocator)
+{
+    return mem_rawfree_loc(ptr, size, allocator, (Source_Location){NULL, 0});
+}
+
+void *
+mem_rawnew_loc(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator, Source_Location location)
 {
     Allocator_Args args = {
         .old_ptr    = NULL,
         .old_size   = 0,
         .new_size   = size,
         .alignment  = align,
+        .location   = location,
+        .out_size   = NULL,
+        .out_ptrs   = NULL,
+        .count      = 0,
     };
     return allocator.fn(out_error, allocator.user_ptr, Allocator_Mode_Alloc, args);
 }
 
 void *
-mem_rawresize(Allocator_Error *out_error, void *old_ptr, size_t old_size, size_t new_size, size_t align, Allocator allocator)
+mem_rawresize_loc(Allocator_Error *out_error, void *old_ptr, size_t old_size, size_t new_size, size_t align, Allocator allocator, Source_Location location)
 {
     Allocator_Args args = {
         .old_ptr    = old_ptr,
         .old_size   = old_size,
         .new_size   = new_size,
         .alignment  = align,
+        .location   = location,
+        .out_size   = NULL,
+        .out_ptrs   = NULL,
+        .count      = 0,
     };
     return allocator.fn(out_error, allocator.user_ptr, Allocator_Mode_Resize, args);
 }
 
 Allocator_Error
-mem_rawfree(void *ptr, size_t size, Allocator allocator)
+mem_rawfree_loc(void *ptr, size_t size, Allocator allocator, Source_Location location)
 {
     Allocator_Args args = {
         .old_ptr    = ptr,
         .old_size   = size,
         .new_size   = 0,
         .alignment  = 0,
+        .location   = location,
+        .out_size   = NULL,
+        .out_ptrs   = NULL,
+        .count      = 0,
     };
     Allocator_Error error;
     allocator.fn(&error, allocator.user_ptr, Allocator_Mode_Free, args);
     return error;
 }
 
+void *
+mem_rawnew_zeroed(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator, Source_Location location)
+{
+    Allocator_Args args = {
+        .old_ptr    = NULL,
+        .old_size   = 0,
+        .new_size   = size,
+        .alignment  = align,
+        .location   = location,
+        .out_size   = NULL,
+        .out_ptrs   = NULL,
+        .count      = 0,
+    };
+    void *data = allocator.fn(out_error, allocator.user_ptr, Allocator_Mode_Alloc_Zeroed, args);
+    if (*out_error != Allocator_Error_Mode_Not_Implemented)
+        return data;
+
+    data = allocator.fn(out_error, allocator.user_ptr, Allocator_Mode_Alloc, args);
+    if (*out_error || data == NULL)
+        return data;
+    return memset(data, 0, size);
+}
+
+void
+mem_rawnew_many(Allocator_Error *out_error, void **out_ptrs, size_t count, size_t size, size_t align, Allocator allocator, Source_Location location)
+{
+    Allocator_Args args = {
+        .old_ptr    = NULL,
+        .old_size   = 0,
+        .new_size   = size,
+        .alignment  = align,
+        .location   = location,
+        .out_size   = NULL,
+        .out_ptrs   = out_ptrs,
+        .count      = count,
+    };
+    allocator.fn(out_error, allocator.user_ptr, Allocator_Mode_Alloc_Many, args);
+    if (*out_error != Allocator_Error_Mode_Not_Implemented)
+        return;
+
+    // Not an error for `count == 0`, which never gets into the loop.
+    *out_error = Allocator_Error_None;
+    for (size_t i = 0; i < count; ++i) {
+        out_ptrs[i] = mem_rawnew_loc(out_error, size, align, allocator, location);
+        if (!*out_error)
+            continue;
+
+        // All or nothing: give back what we got so far.
+        Allocator_Error error = *out_error;
+        while (i > 0)
+            mem_rawfree_loc(out_ptrs[--i], size, allocator, location);
+        *out_error = error;
+        return;
+    }
+}
+
+void *
+mem_rawnew_sized(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator, size_t *out_size, Source_Location location)
+{
+    *out_size = size;
+    Allocator_Args args = {
+        .old_ptr    = NULL,
+        .old_size   = 0,
+        .new_size   = size,
+        .alignment  = align,
+        .location   = location,
+        .out_size   = out_size,
+        .out_ptrs   = NULL,
+        .count      = 0,
+    };
+    return allocator.fn(out_error, allocator.user_ptr, Allocator_Mode_Alloc, args);
+}
+
+void *
+mem_rawresize_sized(Allocator_Error *out_error, void *old_ptr, size_t old_size, size_t new_size, size_t align, Allocator allocator, size_t *out_size, Source_Location location)
+{
+    *out_size = new_size;
+    Allocator_Args args = {
+        .old_ptr    = old_ptr,
+        .old_size   = old_size,
+        .new_size   = new_size,
+        .alignment  = align,
+        .location   = location,
+        .out_size   = out_size,
+        .out_ptrs   = NULL,
+        .count      = 0,
+    };
+    return allocator.fn(out_error, allocator.user_ptr, Allocator_Mode_Resize, args);
+}
+
 #endif // DSA_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,126 @@
+#pragma once
+
+/**
+ * @brief
+ *      The C++ counterpart of `mem/dispatch.h`. Overload resolution picks the
+ *      backing allocator's fast path at compile time, so the arena bump and
+ *      the pool free list pop are inlined into the caller. An `Allocator`
+ *      still works and goes through `Allocator.fn`.
+ *
+ *  ```cpp
+ *          Allocator_Error error;
+ *          CType_Info     *info  = dsa::new_object<CType_Info>(&error, &arena);
+ *          CType         **types = dsa::new_array<CType *>(&error, 16, &pool);
+ *  ```
+ *
+ * @note
+ *      These hand out raw memory, like the `mem_*` macros: no constructors
+ *      nor destructors are run. Keep to trivial types.
+ *
+ *      Only the declarations are taken from the C headers. The implementations
+ *      must still be compiled as C, e.g. a `.c` file which defines
+ *      `DSA_IMPLEMENTATION` before including them.
+ */
+
+#include <type_traits> // std::is_trivially_destructible
+
+extern "C" {
+#include "allocator.h"
+#include "arena.h"
+#include "pool.h"
+}
+
+namespace dsa {
+
+//=== RAW ALLOCATION ======================================================= {{{
+
+inline void *
+rawnew(Allocator_Error *out_error, size_t size, size_t align, Arena *arena)
+{
+    void *data = arena_rawalloc_inline(arena, size, align);
+    *out_error = (data != nullptr) ? Allocator_Error_None : Allocator_Error_Out_Of_Memory;
+    return data;
+}
+
+inline void *
+rawnew(Allocator_Error *out_error, size_t size, size_t align, Pool *pool)
+{
+    // Same limits as `pool_allocator`.
+    void *data = nullptr;
+    if (size <= pool->chunk_size && align <= pool->chunk_align)
+        data = pool_rawalloc_inline(pool);
+    *out_error = (data != nullptr) ? Allocator_Error_None : Allocator_Error_Out_Of_Memory;
+    return data;
+}
+
+inline void *
+rawnew(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator)
+{
+    return mem_rawnew(out_error, size, align, allocator);
+}
+
+inline Allocator_Error
+rawfree(void *, size_t, Arena *)
+{
+    // Same answer as `arena_allocator`.
+    return Allocator_Error_Mode_Not_Implemented;
+}
+
+inline Allocator_Error
+rawfree(void *ptr, size_t, Pool *pool)
+{
+    pool_rawfree(pool, ptr);
+    return Allocator_Error_None;
+}
+
+inline Allocator_Error
+rawfree(void *ptr, size_t size, Allocator allocator)
+{
+    return mem_rawfree(ptr, size, allocator);
+}
+
+//=== }}} ======================================================================
+
+//=== TYPED ALLOCATION ===================================================== {{{
+
+/**
+ * @brief
+ *      `mem_new`, where `backing` is an `Arena *`, a `Pool *` or an `Allocator`.
+ */
+template<class T, class Backing>
+inline T *
+new_object(Allocator_Error *out_error, Backing backing)
+{
+    static_assert(std::is_trivially_destructible<T>::value, "no destructor would be run");
+    return static_cast<T *>(rawnew(out_error, sizeof(T), alignof(T), backing));
+}
+
+/**
+ * @brief
+ *      `mem_make`, where `backing` is an `Arena *`, a `Pool *` or an `Allocator`.
+ */
+template<class T, class Backing>
+inline T *
+new_array(Allocator_Error *out_error, size_t count, Backing backing)
+{
+    static_assert(std::is_trivially_destructible<T>::value, "no destructor would be run");
+    return static_cast<T *>(rawnew(out_error, sizeof(T) * count, alignof(T), backing));
+}
+
+template<class T, class Backing>
+inline Allocator_Error
+free_object(T *ptr, Backing backing)
+{
+    return rawfree(ptr, sizeof(T), backing);
+}
+
+template<class T, class Backing>
+inline Allocator_Error
+free_array(T *ptr, size_t count, Backing backing)
+{
+    return rawfree(ptr, sizeof(T) * count, backing);
+}
+
+//=== }}} ======================================================================
+
+} // namespace dsa
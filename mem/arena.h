@@ -12,12 +12,32 @@
 #define ARENA_PAGE_SIZE    4096
 #endif // ARENA_PAGE_SIZE
 
+/**
+ * @brief
+ *      Scratch memory for the calling thread. Every thread gets its own arena,
+ *      so there is no contention and no locking.
+ *
+ * @note
+ *      A thread's arena is created on its first use, so calling
+ *      `global_temp_allocator_init()` first is optional. However, each thread
+ *      that used it should call `global_temp_allocator_destroy()` before it
+ *      exits, or its blocks are leaked.
+ */
 extern const Allocator
 global_temp_allocator;
 
+/**
+ * @brief
+ *      Initializes the calling thread's scratch arena. Does nothing if it
+ *      already exists.
+ */
 Allocator_Error
 global_temp_allocator_init(void);
 
+/**
+ * @brief
+ *      Frees the calling thread's scratch arena. It is recreated on next use.
+ */
 void
 global_temp_allocator_destroy(void);
 
@@ -31,9 +51,83 @@ struct Memory_Block {
 
 _Static_assert(ARENA_PAGE_SIZE > sizeof(Memory_Block), "ARENA_PAGE_SIZE too small to hold header and data");
 
+#ifndef ARENA_VIRTUAL_RESERVE
+// Default address space reserved by `arena_init_virtual()`. Costs no memory
+// until it is committed.
+#define ARENA_VIRTUAL_RESERVE       (1ULL << 30)
+#endif // ARENA_VIRTUAL_RESERVE
+
+#ifndef ARENA_VIRTUAL_COMMIT_SIZE
+// Virtual arenas commit memory in multiples of this. Must be a multiple of the
+// OS page size.
+#define ARENA_VIRTUAL_COMMIT_SIZE   (1ULL << 16)
+#endif // ARENA_VIRTUAL_COMMIT_SIZE
+
+#ifndef ARENA_HUGE_PAGE_SIZE
+// Commit granularity when using `Arena_Flag_Huge_Pages`. 2 MiB on x86-64.
+#define ARENA_HUGE_PAGE_SIZE        (1ULL << 21)
+#endif // ARENA_HUGE_PAGE_SIZE
+
+typedef enum {
+    // Reserve 1 contiguous range of address space and commit it on demand.
+    // There is only ever 1 `Memory_Block`, so the most recent allocation can
+    // always be extended in place.
+    Arena_Flag_Virtual           = 1 << 0,
+
+    // Ask for transparent huge pages with `MADV_HUGEPAGE`. Memory is still
+    // only committed on demand. Only meaningful along with `Arena_Flag_Virtual`.
+    Arena_Flag_Huge_Pages        = 1 << 1,
+
+    // Back the whole reservation with explicit huge pages (`MAP_HUGETLB`),
+    // taken from the system's shared pool up front. Falls back to
+    // `Arena_Flag_Huge_Pages` if the pool is too small. Implies it.
+    Arena_Flag_Huge_Pages_Pinned = 1 << 2,
+} Arena_Flag;
+
+#ifndef ARENA_MAX_BLOCK_SIZE
+// New blocks double in size, starting from `ARENA_PAGE_SIZE`, up to this.
+// Allocations larger than this still get a block big enough for them.
+#define ARENA_MAX_BLOCK_SIZE    (1 << 20)
+#endif // ARENA_MAX_BLOCK_SIZE
+
+#ifndef ARENA_FREE_LIST_MAX
+// How many blocks `arena_free_all()` keeps around for reuse instead of freeing.
+#define ARENA_FREE_LIST_MAX     8
+#endif // ARENA_FREE_LIST_MAX
+
+#ifndef ARENA_TAIL_COUNT
+// How many retired blocks with leftover space an arena remembers.
+#define ARENA_TAIL_COUNT    4
+#endif // ARENA_TAIL_COUNT
+
+#ifndef ARENA_TAIL_MIN
+// Retired blocks with fewer free bytes than this are not worth remembering.
+#define ARENA_TAIL_MIN      64
+#endif // ARENA_TAIL_MIN
+
+/**
+ * @note
+ *      Allocation only ever bumps `begin`. When it is full, a new block takes
+ *      its place. If the old block still has at least `ARENA_TAIL_MIN` bytes
+ *      free, it is remembered in `tails`. That way we can still make use of it
+ *      without ever walking the whole chain. Smaller leftovers are abandoned
+ *      until the next `arena_free_all()`.
+ *
+ *      `arena_free_all()` keeps up to `ARENA_FREE_LIST_MAX` of the blocks it
+ *      releases in `free_list`, and new blocks are taken from there first.
+ *      A workload that repeatedly fills and resets the arena thus stops
+ *      calling `malloc` and `free` once it has warmed up.
+ */
 typedef struct {
-    Memory_Block *begin; // Primary block we are allocating from.
-    Memory_Block *end;   // The oldest block we have.
+    Memory_Block *begin;      // Primary block we are allocating from.
+    Memory_Block *end;        // The oldest block we have.
+    Arena_Flag    flags;      // Bit set of `Arena_Flag`.
+    size_t        reserved;   // Virtual arenas: size of the whole mapping, header included.
+    size_t        dirty;      // Virtual arenas: bytes of `base` past this and `used` are still zero.
+    Memory_Block *tails[ARENA_TAIL_COUNT]; // Retired blocks with space to spare, or `NULL`.
+    Memory_Block *free_list;  // Blocks ready for reuse, chained through `prev`.
+    size_t        free_count; // Length of `free_list`, at most `ARENA_FREE_LIST_MAX`.
+    size_t        block_size; // Size of the next new block, header included.
 } Arena;
 
 /**
@@ -46,6 +140,35 @@ typedef struct {
 Allocator_Error
 arena_init(Arena *arena);
 
+/**
+ * @brief
+ *      Initializes `arena` as a virtual memory arena. `reserve` bytes of
+ *      address space are mapped with no access and pages are committed as
+ *      allocations need them. Growth is always contiguous.
+ *
+ * @param reserve
+ *      Upper bound on everything `arena` can ever hold. Pass 0 to use
+ *      `ARENA_VIRTUAL_RESERVE`.
+ *
+ * @param flags
+ *      `Arena_Flag_Virtual` is implied. Add `Arena_Flag_Huge_Pages` to back
+ *      the arena with huge pages where the OS allows it.
+ *
+ *      `Arena_Flag_Huge_Pages_Pinned` instead takes all of `reserve` from the
+ *      hugetlb pool right away, before anything is committed: the default
+ *      1 GiB is 512 pages of 2 MiB. Only use it with a small, explicit
+ *      `reserve`.
+ *
+ * @return
+ *      `Allocator_Error_Mode_Not_Implemented` on platforms without `mmap`.
+ *
+ * @note
+ *      Needs `_DEFAULT_SOURCE` (or similar) for `MAP_ANONYMOUS` when compiling
+ *      with `-std=c11`. The `Makefile` defines `_GNU_SOURCE`, which implies it.
+ */
+Allocator_Error
+arena_init_virtual(Arena *arena, size_t reserve, Arena_Flag flags);
+
 /**
  * @brief
  *      Deallocates all the memory, including our owned memory blocks, associated
@@ -87,6 +210,54 @@ arena_allocator(Arena *arena);
 void *
 arena_rawalloc(Arena *arena, size_t size, size_t align);
 
+/**
+ * @brief
+ *      `arena_rawalloc`, but the memory is all zero.
+ *
+ * @note
+ *      Virtual arenas remember how far they have ever been written to. Pages
+ *      past that are fresh from the OS and thus already zero, so only the part
+ *      of the allocation below it is cleared.
+ */
+void *
+arena_rawalloc_zeroed(Arena *arena, size_t size, size_t align);
+
+/**
+ * @brief
+ *      Allocate `count` objects of `size` bytes each with a single bump,
+ *      writing their addresses to `out_ptrs`.
+ *
+ * @return
+ *      The first object, or `NULL` if there was no room for all of them. The
+ *      objects are contiguous, `size` rounded up to `align` apart.
+ */
+void *
+arena_rawalloc_many(Arena *arena, void **out_ptrs, size_t count, size_t size, size_t align);
+
+/**
+ * @brief
+ *      The fast path of `arena_rawalloc` which the compiler can inline: bump
+ *      the current block, or call `arena_rawalloc` if it is full.
+ *
+ * @note
+ *      `align` must be a nonzero power of 2.
+ */
+static inline void *
+arena_rawalloc_inline(Arena *arena, size_t size, size_t align)
+{
+    Memory_Block *block = arena->begin;
+    uintptr_t     base  = cast(uintptr_t)block->base;
+    uintptr_t     start = (base + block->used + (align - 1)) & ~cast(uintptr_t)(align - 1);
+    size_t        used  = cast(size_t)(start - base) + size;
+
+    // The second check catches `size` so large that `used` wrapped around.
+    if (used <= block->size && used >= size) {
+        block->used = used;
+        return cast(void *)start;
+    }
+    return arena_rawalloc(arena, size, align);
+}
+
 /**
  * @brief
  *      Low level memory resizing function for `Arena`. May give you back the
@@ -104,6 +275,10 @@ arena_rawresize(Arena *arena, void *old_ptr, size_t old_size, size_t new_size, s
  * @brief
  *      Frees all allocated sub-arenas in our list of owned memory blocks, except
  *      for the very first one we allocated.
+ *
+ * @note
+ *      Virtual arenas keep their committed pages so that they can be reused
+ *      without faulting them in again.
  */
 void
 arena_free_all(Arena *arena);
@@ -125,10 +300,77 @@ arena_free_all(Arena *arena);
 size_t
 arena_get_usage(const Arena *arena, size_t *out_total);
 
+/**
+ * @brief
+ *      A checkpoint in an `Arena`. Everything allocated after
+ *      `arena_temp_begin()` is released by the matching `arena_temp_end()`,
+ *      while everything allocated before it is left alone.
+ *
+ * @note
+ *      Regions may be nested, but they must end in the reverse order they
+ *      began. Do not call `arena_free_all()` while one is active.
+ */
+typedef struct {
+    Arena        *arena;
+    Memory_Block *block; // `arena->begin` at the checkpoint.
+    size_t        used;  // `block->used` at the checkpoint.
+    Memory_Block *tails[ARENA_TAIL_COUNT];
+    size_t        tails_used[ARENA_TAIL_COUNT];
+} Arena_Temp;
+
+/**
+ * @brief
+ *      Start a scratch region in `arena`. See `Arena_Temp`.
+ */
+Arena_Temp
+arena_temp_begin(Arena *arena);
+
+/**
+ * @brief
+ *      Release everything allocated in `arena` since `temp` began. This does
+ *      not depend on the number of allocations made; blocks chained since
+ *      then are moved to the free list (or freed) one at a time.
+ */
+void
+arena_temp_end(Arena_Temp temp);
+
+/**
+ * @brief
+ *      Start a scratch region on the calling thread's `global_temp_allocator`.
+ *      End it with `arena_temp_end()` as usual.
+ */
+Arena_Temp
+global_temp_allocator_begin(void);
+
 #ifdef DSA_ARENA_IMPLEMENTATION
 
 #include <assert.h> // assert
-#include <string.h> // memcpy
+#include <string.h> // memcpy, memset
+
+/**
+ * @brief
+ *      Internal implementation function. If `data` is the newest allocation of
+ *      `arena->begin`, let the caller have some of the rest of the block: up to
+ *      as much again as it asked for. Growable buffers would ask for that much
+ *      on their next resize anyway.
+ */
+static void
+_arena_report_size(Arena *arena, void *data, Allocator_Args args)
+{
+    Memory_Block *block = arena->begin;
+    if (args.out_size == NULL || data == NULL || block == NULL)
+        return;
+
+    char *end = cast(char *)data + args.new_size;
+    if (end != block->base + block->used)
+        return;
+
+    size_t extra = block->size - block->used;
+    if (extra > args.new_size)
+        extra = args.new_size;
+    block->used    += extra;
+    *args.out_size  = args.new_size + extra;
+}
 
 static void *
 _arena_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
@@ -139,6 +381,20 @@ _arena_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode m
     switch (mode) {
     case Allocator_Mode_Alloc:
         data = arena_rawalloc(arena, args.new_size, args.alignment);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        _arena_report_size(arena, data, args);
+        break;
+
+    case Allocator_Mode_Alloc_Zeroed:
+        data = arena_rawalloc_zeroed(arena, args.new_size, args.alignment);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        _arena_report_size(arena, data, args);
+        break;
+
+    case Allocator_Mode_Alloc_Many:
+        data = arena_rawalloc_many(arena, args.out_ptrs, args.count, args.new_size, args.alignment);
         if (data == NULL)
             *out_error = Allocator_Error_Out_Of_Memory;
         break;
@@ -147,6 +403,7 @@ _arena_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode m
         data = arena_rawresize(arena, args.old_ptr, args.old_size, args.new_size, args.alignment);
         if (data == NULL)
             *out_error = Allocator_Error_Out_Of_Memory;
+        _arena_report_size(arena, data, args);
         break;
 
     case Allocator_Mode_Free:
@@ -163,11 +420,47 @@ _arena_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode m
     return data;
 }
 
-static Arena
-_global_arena = {NULL, NULL};
+static _Thread_local Arena
+_global_arena = {NULL, NULL, 0, 0, 0, {NULL}, NULL, 0, 0};
 
+/**
+ * @brief
+ *      Internal implementation function. Get the calling thread's arena,
+ *      initializing it first if need be.
+ *
+ * @return
+ *      `NULL` if it could not be initialized.
+ */
+static Arena *
+_global_temp_arena(void)
+{
+    Arena *arena = &_global_arena;
+    if (arena->begin == NULL && arena_init(arena))
+        return NULL;
+    return arena;
+}
+
+static void *
+_global_temp_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    unused(user_ptr);
+    // Nothing to free if this thread never allocated.
+    if (mode == Allocator_Mode_Free_All && _global_arena.begin == NULL) {
+        *out_error = Allocator_Error_None;
+        return NULL;
+    }
+
+    Arena *arena = _global_temp_arena();
+    if (arena == NULL) {
+        *out_error = Allocator_Error_Out_Of_Memory;
+        return NULL;
+    }
+    return _arena_allocator_fn(out_error, arena, mode, args);
+}
+
+// The user pointer is unused: each thread resolves its own arena.
 const Allocator
-global_temp_allocator = {&_arena_allocator_fn, &_global_arena};
+global_temp_allocator = {&_global_temp_allocator_fn, NULL};
 
 #include <stdlib.h> // malloc, free, exit
 
@@ -200,9 +493,176 @@ _arena_max(size_t a, size_t b)
     return a > b ? a : b;
 }
 
+/**
+ * @brief
+ *      Get a block that fits at least `size` bytes, header included, to be
+ *      chained after `arena->begin`. Reuses a block from `arena->free_list` if
+ *      one is big enough, otherwise allocates one of the next geometric size.
+ */
+static Memory_Block *
+_arena_acquire_block(Arena *arena, size_t size)
+{
+    // The free list is bounded by `ARENA_FREE_LIST_MAX`, so this is O(1).
+    for (Memory_Block **link = &arena->free_list; *link != NULL; link = &(*link)->prev) {
+        Memory_Block *block = *link;
+        if (sizeof(*block) + block->size < size)
+            continue;
+
+        *link = block->prev;
+        --arena->free_count;
+        block->prev = arena->begin;
+        block->used = 0;
+        return block;
+    }
+
+    size_t block_size = arena->block_size;
+    if (block_size < ARENA_MAX_BLOCK_SIZE)
+        arena->block_size = block_size * 2;
+    return _arena_memory_block_new(_arena_max(size, block_size), arena->begin);
+}
+
+/**
+ * @brief
+ *      Keep `block` for reuse if there is room in `arena->free_list`,
+ *      otherwise give it back to the system.
+ */
+static void
+_arena_release_block(Arena *arena, Memory_Block *block)
+{
+    if (arena->free_count >= ARENA_FREE_LIST_MAX) {
+        _arena_memory_block_free(block);
+        return;
+    }
+    block->prev      = arena->free_list;
+    arena->free_list = block;
+    ++arena->free_count;
+}
+
+//=== VIRTUAL MEMORY ======================================================= {{{
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARENA_HAS_VIRTUAL_MEMORY
+#include <sys/mman.h> // mmap, mprotect, madvise, munmap
+#endif
+
+// Assumes `multiple` is a power of 2.
+static inline size_t
+_arena_align_up(size_t size, size_t multiple)
+{
+    return (size + (multiple - 1)) & ~(multiple - 1);
+}
+
+static inline size_t
+_arena_virtual_granularity(const Arena *arena)
+{
+    return (arena->flags & Arena_Flag_Huge_Pages) ? ARENA_HUGE_PAGE_SIZE : ARENA_VIRTUAL_COMMIT_SIZE;
+}
+
+/**
+ * @brief
+ *      Commit enough pages for `block->base` to hold at least `size` bytes.
+ *
+ * @return
+ *      `false` if `size` does not fit in the reservation or the OS refused.
+ */
+static bool
+_arena_virtual_commit(Arena *arena, Memory_Block *block, size_t size)
+{
+#ifdef ARENA_HAS_VIRTUAL_MEMORY
+    const size_t header    = sizeof(*block);
+    const size_t committed = header + block->size;
+    if (size > arena->reserved - header)
+        return false;
+
+    size_t target = _arena_align_up(header + size, _arena_virtual_granularity(arena));
+    if (target > arena->reserved)
+        target = arena->reserved;
+    if (target <= committed)
+        return true;
+
+    if (mprotect(cast(char *)block + committed, target - committed, PROT_READ | PROT_WRITE) != 0)
+        return false;
+    block->size = target - header;
+    return true;
+#else // !ARENA_HAS_VIRTUAL_MEMORY
+    unused(arena);
+    unused(block);
+    unused(size);
+    return false;
+#endif // ARENA_HAS_VIRTUAL_MEMORY
+}
+
+Allocator_Error
+arena_init_virtual(Arena *arena, size_t reserve, Arena_Flag flags)
+{
+#ifdef ARENA_HAS_VIRTUAL_MEMORY
+    flags |= Arena_Flag_Virtual;
+    if (flags & Arena_Flag_Huge_Pages_Pinned)
+        flags |= Arena_Flag_Huge_Pages;
+    *arena = (Arena){
+        .begin      = NULL,
+        .end        = NULL,
+        .flags      = flags,
+        .reserved   = 0,
+        .dirty      = 0,
+        .tails      = {NULL},
+        .free_list  = NULL,
+        .free_count = 0,
+        .block_size = 0,
+    };
+
+    reserve = _arena_align_up((reserve == 0) ? ARENA_VIRTUAL_RESERVE : reserve, _arena_virtual_granularity(arena));
+    void *base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages are accounted for at `mmap` time, so this fails
+    // cleanly (rather than with `SIGBUS` later) if the pool is too small.
+    if (flags & Arena_Flag_Huge_Pages_Pinned)
+        base = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif // MAP_HUGETLB
+
+    if (base == MAP_FAILED) {
+        base = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED)
+            return Allocator_Error_Out_Of_Memory;
+#ifdef MADV_HUGEPAGE
+        // Only a hint. Transparent huge pages may be disabled system-wide.
+        if (flags & Arena_Flag_Huge_Pages)
+            madvise(base, reserve, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+    }
+
+    Memory_Block *block = cast(Memory_Block *)base;
+    arena->reserved = reserve;
+
+    // The header itself lives in the first committed pages.
+    if (mprotect(base, _arena_virtual_granularity(arena), PROT_READ | PROT_WRITE) != 0) {
+        munmap(base, reserve);
+        return Allocator_Error_Out_Of_Memory;
+    }
+    block->prev = NULL;
+    block->used = 0;
+    block->size = _arena_virtual_granularity(arena) - sizeof(*block);
+
+    arena->begin = block;
+    arena->end   = block;
+    return Allocator_Error_None;
+#else // !ARENA_HAS_VIRTUAL_MEMORY
+    unused(arena);
+    unused(reserve);
+    unused(flags);
+    return Allocator_Error_Mode_Not_Implemented;
+#endif // ARENA_HAS_VIRTUAL_MEMORY
+}
+
+//=== }}} ======================================================================
+
 Allocator_Error
 global_temp_allocator_init(void)
 {
+    // Already created on first use; initializing again would leak it.
+    if (_global_arena.begin != NULL)
+        return Allocator_Error_None;
     return arena_init(&_global_arena);
 }
 
@@ -212,6 +672,14 @@ global_temp_allocator_destroy(void)
     arena_destroy(&_global_arena);
 }
 
+Arena_Temp
+global_temp_allocator_begin(void)
+{
+    // If initialization fails, so will every allocation in the region.
+    Arena *arena = _global_temp_arena();
+    return arena_temp_begin((arena != NULL) ? arena : &_global_arena);
+}
+
 Allocator_Error
 arena_init(Arena *arena)
 {
@@ -221,6 +689,13 @@ arena_init(Arena *arena)
     *arena = (Arena){
         .begin      = block,
         .end        = block,
+        .flags      = 0,
+        .reserved   = 0,
+        .dirty      = 0,
+        .tails      = {NULL},
+        .free_list  = NULL,
+        .free_count = 0,
+        .block_size = ARENA_PAGE_SIZE * 2,
     };
     return Allocator_Error_None;
 }
@@ -228,13 +703,30 @@ arena_init(Arena *arena)
 void
 arena_destroy(Arena *arena)
 {
+#ifdef ARENA_HAS_VIRTUAL_MEMORY
+    if (arena->flags & Arena_Flag_Virtual) {
+        if (arena->begin != NULL)
+            munmap(arena->begin, arena->reserved);
+        arena->begin = NULL;
+        arena->end   = NULL;
+        return;
+    }
+#endif // ARENA_HAS_VIRTUAL_MEMORY
+
     for (Memory_Block *block = arena->begin; block != NULL;) {
         Memory_Block *prev = block->prev;
         _arena_memory_block_free(block);
         block = prev;
     }
-    arena->begin = NULL;
-    arena->end   = NULL;
+    for (Memory_Block *block = arena->free_list; block != NULL;) {
+        Memory_Block *prev = block->prev;
+        _arena_memory_block_free(block);
+        block = prev;
+    }
+    arena->begin      = NULL;
+    arena->end        = NULL;
+    arena->free_list  = NULL;
+    arena->free_count = 0;
 }
 
 Allocator
@@ -246,36 +738,70 @@ arena_allocator(Arena *arena)
 
 /**
  * @brief
- *      Internal implementation function. This makes many assumptions.
- *      Do NOT use!
+ *      Internal implementation function. Bump `block` if the aligned
+ *      allocation fits.
  *
- * @note
- *      This function assumes the following:
- *          1. `block` has at least `size` bytes available, not accounting for alignment.
- *          2. Because of #1, we don't need to allocate a new block.
+ * @return
+ *      `NULL` if `block` does not have enough space left.
  */
-static void *
+static inline void *
 _arena_memory_block_rawalloc(Memory_Block *block, size_t size, size_t align)
 {
+    // x % pow2 == x & (pow2 - 1), so rounding up is just a mask.
+    assert(align != 0 && (align & (align - 1)) == 0);
     uintptr_t base_addr  = cast(uintptr_t)block->base;
-    uintptr_t start_addr = base_addr + block->used;
+    uintptr_t start_addr = (base_addr + block->used + (align - 1)) & ~cast(uintptr_t)(align - 1);
+    size_t    used       = cast(size_t)(start_addr - base_addr) + size;
 
-    // Adjust for alignment (assuming alignment is a power of 2)
-    // x % pow2 == x & (pow2 - 1)
-    while ((start_addr & (align - 1)) != 0) {
-        ++start_addr;
+    // New aligned allocation fits? The second check guards against overflow.
+    if (used <= block->size && used >= size) {
+        block->used = used;
+        return cast(void *)start_addr;
     }
+    return NULL;
+}
 
-    uintptr_t end_addr = start_addr + size;
+/**
+ * @brief
+ *      Internal implementation function. Give back the bytes of `block` past
+ *      `used`. Virtual arenas first note how far the block was written to.
+ */
+static inline void
+_arena_block_rewind(Arena *arena, Memory_Block *block, size_t used)
+{
+    if ((arena->flags & Arena_Flag_Virtual) && block->used > arena->dirty)
+        arena->dirty = block->used;
+    block->used = used;
+}
 
-    // New aligned allocation fits?
-    if (end_addr <= base_addr + block->size) {
-        // Same concept as getting the length of an array by subtracting 1-past-
-        // end-pointer and base pointer.
-        block->used = end_addr - base_addr;
-        return cast(void *)start_addr;
+/**
+ * @brief
+ *      Remember `block` in `arena->tails` if it has enough space left to be
+ *      worth it. When all the tails are taken, the one with the least space
+ *      left is replaced if `block` has more.
+ */
+static void
+_arena_retire_block(Arena *arena, Memory_Block *block)
+{
+    size_t free_size = block->size - block->used;
+    if (free_size < ARENA_TAIL_MIN)
+        return;
+
+    Memory_Block **victim      = NULL;
+    size_t         victim_free = free_size;
+    for (size_t i = 0; i < ARENA_TAIL_COUNT; ++i) {
+        Memory_Block *tail = arena->tails[i];
+        if (tail == NULL) {
+            victim = &arena->tails[i];
+            break;
+        }
+        if (tail->size - tail->used < victim_free) {
+            victim      = &arena->tails[i];
+            victim_free = tail->size - tail->used;
+        }
     }
-    return NULL;
+    if (victim != NULL)
+        *victim = block;
 }
 
 /**
@@ -292,94 +818,225 @@ _arena_memory_block_rawalloc(Memory_Block *block, size_t size, size_t align)
 static void *
 _arena_chain_new_block_and_alloc(Arena *arena, size_t size, size_t align)
 {
-    // TODO: Ensure this is a power of 2?
-    const size_t  block_size = _arena_max(size + sizeof(Memory_Block), ARENA_PAGE_SIZE);
-    Memory_Block *new_block  = _arena_memory_block_new(block_size, arena->begin);
+    // Virtual arenas never chain; they grow the only block they have.
+    if (arena->flags & Arena_Flag_Virtual) {
+        Memory_Block *block = arena->begin;
+        if (!_arena_virtual_commit(arena, block, block->used + size + align))
+            return NULL;
+        return _arena_memory_block_rawalloc(block, size, align);
+    }
+
+    // Leave room for the worst-case alignment padding.
+    Memory_Block *new_block = _arena_acquire_block(arena, size + align + sizeof(Memory_Block));
     if (new_block == NULL)
         return NULL;
 
     // `new_block` is now the primary block we'll be allocating from here on.
+    _arena_retire_block(arena, arena->begin);
     arena->begin = new_block;
     return _arena_memory_block_rawalloc(new_block, size, align);
 }
 
+/**
+ * @brief
+ *      The slow path of `arena_rawalloc()`, for when `arena->begin` is full.
+ *      The work is bounded: at most `ARENA_TAIL_COUNT` tries before we chain
+ *      a new block.
+ */
+static void *
+_arena_rawalloc_slow(Arena *arena, size_t size, size_t align)
+{
+    for (size_t i = 0; i < ARENA_TAIL_COUNT; ++i) {
+        Memory_Block *tail = arena->tails[i];
+        if (tail == NULL)
+            continue;
+
+        void *data = _arena_memory_block_rawalloc(tail, size, align);
+        if (data == NULL)
+            continue;
+
+        // Stop remembering tails that have become too small to matter.
+        if (tail->size - tail->used < ARENA_TAIL_MIN)
+            arena->tails[i] = NULL;
+        return data;
+    }
+    return _arena_chain_new_block_and_alloc(arena, size, align);
+}
+
 void *
 arena_rawalloc(Arena *arena, size_t size, size_t align)
 {
-    // Find the first sub-block that can accomodate our allocation.
-    for (Memory_Block *block = arena->begin; block != NULL; block = block->prev) {
-        // Do we even have a chance of accomodating this allocation?
-        if (block->used + size > block->size)
-            continue;
+    void *data = _arena_memory_block_rawalloc(arena->begin, size, align);
+    if (data != NULL)
+        return data;
+    return _arena_rawalloc_slow(arena, size, align);
+}
+
+void *
+arena_rawalloc_zeroed(Arena *arena, size_t size, size_t align)
+{
+    char *data = cast(char *)arena_rawalloc(arena, size, align);
+    if (data == NULL)
+        return NULL;
 
-        void *data = _arena_memory_block_rawalloc(block, size, align);
-        if (data != NULL)
-            return data;
+    // Blocks from `malloc` may hold anything, and are reused besides.
+    size_t clear = size;
+    if (arena->flags & Arena_Flag_Virtual) {
+        size_t offset = cast(size_t)(data - arena->begin->base);
+        clear = (arena->dirty > offset) ? arena->dirty - offset : 0;
+        if (clear > size)
+            clear = size;
     }
+    memset(data, 0, clear);
+    return data;
+}
 
-    // We couldn't find a spare block that could accomodate us.
-    return _arena_chain_new_block_and_alloc(arena, size, align);
+void *
+arena_rawalloc_many(Arena *arena, void **out_ptrs, size_t count, size_t size, size_t align)
+{
+    size_t stride = _arena_align_up(size, align);
+    if (stride != 0 && count > SIZE_MAX / stride)
+        return NULL;
+
+    char *data = cast(char *)arena_rawalloc(arena, stride * count, align);
+    if (data == NULL)
+        return NULL;
+    for (size_t i = 0; i < count; ++i)
+        out_ptrs[i] = data + i * stride;
+    return data;
+}
+
+/**
+ * @brief
+ *      Find the block in which `old_ptr` is the most recent allocation. Only
+ *      the blocks we can still allocate from are checked, so this is O(1).
+ *
+ * @return
+ *      `NULL` if there is no such block.
+ */
+static Memory_Block *
+_arena_find_top_block(Arena *arena, const void *old_ptr, size_t old_size)
+{
+    Memory_Block *block = arena->begin;
+    for (size_t i = 0; /* empty */; ++i) {
+        if (block != NULL && block->used >= old_size && block->base + (block->used - old_size) == old_ptr)
+            return block;
+        if (i >= ARENA_TAIL_COUNT)
+            return NULL;
+        block = arena->tails[i];
+    }
 }
 
 void *
 arena_rawresize(Arena *arena, void *old_ptr, size_t old_size, size_t new_size, size_t align)
 {
-    // Try to find the sub-block where `old_ptr` came from. There is no other
-    // portable way of doing this!
-    for (Memory_Block *block = arena->begin; block != NULL; block = block->prev) {
-        // If `old_ptr` matches the most recent allocation, we might be able to
-        // extend it.
-        const void *latest_alloc = block->base + (block->used - old_size);
-        if (old_ptr != latest_alloc)
-            continue;
-
+    // If `old_ptr` matches the most recent allocation, we might be able to
+    // extend it.
+    Memory_Block *block     = (old_ptr != NULL) ? _arena_find_top_block(arena, old_ptr, old_size) : NULL;
+    bool          is_shrink = old_size >= new_size;
+    if (block != NULL) {
         // If shrinking, just mark the excess memory as reusable.
-        bool is_shrink = old_size >= new_size;
         if (is_shrink) {
-            block->used -= old_size - new_size;
+            _arena_block_rewind(arena, block, block->used - (old_size - new_size));
             return old_ptr;
         }
 
         // Does extending the allocation fit?
         size_t added_size  = new_size - old_size;
         size_t result_size = block->used + added_size;
-
-        // TODO: check if this is an off-by-one error, or if it's valid
         if (result_size <= block->size) {
             block->used = result_size;
             return old_ptr;
         }
 
-        // We can't extend, so we know we need to get rid of this allocation from
-        // this block. We `break` because in `arena_rawalloc()` we will check for
-        // blocks that can accomodate us, or allocate a new block.
-        block->used -= old_size;
-        break;
+        // Virtual arenas can always extend the top allocation in place.
+        // If even that fails then so would moving it, so leave it be.
+        if (arena->flags & Arena_Flag_Virtual) {
+            if (!_arena_virtual_commit(arena, block, result_size))
+                return NULL;
+            block->used = result_size;
+            return old_ptr;
+        }
     }
 
+    // Not on top, but a smaller allocation still fits where it already is.
+    if (is_shrink && old_ptr != NULL)
+        return old_ptr;
+
     // Unable to extend; we should try to get a new allocation from some other
     // block or even allocate a new block that can accomodate us.
     void *new_ptr = arena_rawalloc(arena, new_size, align);
+    if (new_ptr == NULL)
+        return NULL;
 
     // memcpy with NULL argument/s is undefined behavior.
-    if (new_ptr != NULL && old_ptr != NULL)
-        return memcpy(new_ptr, old_ptr, old_size);
-    else
-        return new_ptr;
+    if (old_ptr != NULL)
+        memcpy(new_ptr, old_ptr, old_size);
+
+    // Only now that the data is safe can we give back the old space. The new
+    // allocation could not have come from `block`, so `old_ptr` is still on top.
+    if (block != NULL)
+        _arena_block_rewind(arena, block, block->used - old_size);
+    return new_ptr;
 }
 
 void
 arena_free_all(Arena *arena)
 {
     Memory_Block *end = arena->end;
-    // Maybe we shouldn't free the extra pages just yet?
+    // Newest blocks come first and are the biggest, so those get reused.
     for (Memory_Block *block = arena->begin; block != end;) {
         Memory_Block *prev = block->prev;
-        _arena_memory_block_free(block);
+        _arena_release_block(arena, block);
         block = prev;
     }
-    end->used = 0;
+    _arena_block_rewind(arena, end, 0);
     arena->begin = end;
+    for (size_t i = 0; i < ARENA_TAIL_COUNT; ++i)
+        arena->tails[i] = NULL;
+}
+
+Arena_Temp
+arena_temp_begin(Arena *arena)
+{
+    Memory_Block *block = arena->begin;
+    Arena_Temp    temp  = {
+        .arena = arena,
+        .block = block,
+        .used  = (block != NULL) ? block->used : 0,
+    };
+
+    // Tails are older than `block`, but we may still allocate from them.
+    for (size_t i = 0; i < ARENA_TAIL_COUNT; ++i) {
+        Memory_Block *tail = arena->tails[i];
+        temp.tails[i]      = tail;
+        temp.tails_used[i] = (tail != NULL) ? tail->used : 0;
+    }
+    return temp;
+}
+
+void
+arena_temp_end(Arena_Temp temp)
+{
+    Arena *arena = temp.arena;
+    if (temp.block == NULL)
+        return;
+
+    // Blocks chained since the checkpoint hold nothing but scratch data.
+    for (Memory_Block *block = arena->begin; block != temp.block;) {
+        Memory_Block *prev = block->prev;
+        _arena_release_block(arena, block);
+        block = prev;
+    }
+    arena->begin     = temp.block;
+    _arena_block_rewind(arena, temp.block, temp.used);
+
+    for (size_t i = 0; i < ARENA_TAIL_COUNT; ++i) {
+        Memory_Block *tail = temp.tails[i];
+        arena->tails[i] = tail;
+        if (tail != NULL)
+            tail->used = temp.tails_used[i];
+    }
 }
 
 size_t
@@ -0,0 +1,220 @@
+#pragma once
+
+#ifdef DSA_IMPLEMENTATION
+#define DSA_BUDGET_IMPLEMENTATION
+#endif // DSA_IMPLEMENTATION
+
+#include "../common.h"
+#include "allocator.h"
+
+#include <stdatomic.h>
+
+typedef struct Budget_Allocator Budget_Allocator;
+
+/**
+ * @brief
+ *      Called by the request that brought `budget` within `low_watermark` bytes
+ *      of its limit, or would have if it had fit. `used` is the usage that
+ *      request brought it to, or would have.
+ *
+ * @note
+ *      This runs in the middle of whatever was allocating, e.g. halfway through
+ *      growing a hash table, possibly on another thread. Only release memory
+ *      that nobody is using right now, or make a note for the owner of a cache
+ *      to shed it at a safe point.
+ */
+typedef void (*Budget_Callback)(Budget_Allocator *budget, size_t used, void *user_ptr);
+
+/**
+ * @brief
+ *      Wraps any `Allocator` and holds everything that goes through it to
+ *      `limit` bytes. Past that, requests fail cleanly with
+ *      `Allocator_Error_Out_Of_Memory` and never reach `inner`.
+ *
+ *      Before that happens, `on_low_watermark` gets a chance to shed memory:
+ *      it is called each time usage rises to within `low_watermark` bytes of
+ *      `limit`, and for each request that would have but was refused. After
+ *      usage drops back below that, it is called again on the next rise.
+ *
+ * @note
+ *      Thread-safe as long as `inner` is. Each request costs 1 atomic add
+ *      (and 1 more to give the bytes back if it fails). The atomic add also
+ *      tells exactly 1 thread that it crossed the watermark.
+ *
+ *      `Allocator_Mode_Free_All` resets the usage to 0, so `inner` should not
+ *      be shared with anything outside of the budget.
+ */
+struct Budget_Allocator {
+    Allocator        inner;
+    size_t           limit;
+    size_t           low_watermark;    // Headroom in bytes; 0 for no callback.
+    Budget_Callback  on_low_watermark;
+    void            *user_ptr;         // Passed on to `on_low_watermark`.
+    _Atomic(size_t)  used;
+    _Atomic(size_t)  rejected;         // Requests refused for going over `limit`.
+};
+
+void
+budget_allocator_init(Budget_Allocator *budget, Allocator inner, size_t limit,
+    size_t low_watermark, Budget_Callback on_low_watermark, void *user_ptr);
+
+/**
+ * @brief
+ *      Create a stack-allocated `Allocator` instance which forwards everything
+ *      within budget to `budget->inner`.
+ */
+Allocator
+budget_allocator(Budget_Allocator *budget);
+
+/**
+ * @brief
+ *      Get the number of bytes currently charged to `budget`.
+ */
+size_t
+budget_allocator_used(const Budget_Allocator *budget);
+
+#ifdef DSA_BUDGET_IMPLEMENTATION
+
+#include <assert.h> // assert
+
+void
+budget_allocator_init(Budget_Allocator *budget, Allocator inner, size_t limit,
+    size_t low_watermark, Budget_Callback on_low_watermark, void *user_ptr)
+{
+    assert(low_watermark <= limit);
+    budget->inner            = inner;
+    budget->limit            = limit;
+    budget->low_watermark    = low_watermark;
+    budget->on_low_watermark = on_low_watermark;
+    budget->user_ptr         = user_ptr;
+    atomic_init(&budget->used, 0);
+    atomic_init(&budget->rejected, 0);
+}
+
+size_t
+budget_allocator_used(const Budget_Allocator *budget)
+{
+    return atomic_load_explicit(&budget->used, memory_order_relaxed);
+}
+
+static void
+_budget_release(Budget_Allocator *budget, size_t size)
+{
+    if (size != 0)
+        atomic_fetch_sub_explicit(&budget->used, size, memory_order_relaxed);
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Charge `size` more bytes to `budget`.
+ *
+ * @return
+ *      `false` if that would go over the limit, in which case nothing is
+ *      charged.
+ */
+static bool
+_budget_charge(Budget_Allocator *budget, size_t size)
+{
+    if (size == 0)
+        return true;
+
+    size_t before = atomic_fetch_add_explicit(&budget->used, size, memory_order_relaxed);
+    size_t after  = before + size;
+    bool   fits   = after >= before && after <= budget->limit;
+    if (!fits) {
+        _budget_release(budget, size);
+        atomic_fetch_add_explicit(&budget->rejected, 1, memory_order_relaxed);
+    }
+
+    // Only the caller whose add crossed the line gets to see it. Requests that
+    // would have crossed it but did not fit count too: a big table resize is
+    // often the first sign of trouble.
+    size_t line = budget->limit - budget->low_watermark;
+    if (budget->on_low_watermark != NULL && before < line && (after >= line || after < before))
+        budget->on_low_watermark(budget, after, budget->user_ptr);
+    return fits;
+}
+
+static void *
+_budget_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Budget_Allocator *budget = cast(Budget_Allocator *)user_ptr;
+    Allocator         inner  = budget->inner;
+
+    // Only growth is charged up front; shrinking is given back on success.
+    size_t charged = 0;
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+    case Allocator_Mode_Alloc_Zeroed:
+        charged = args.new_size;
+        break;
+
+    case Allocator_Mode_Alloc_Many:
+        if (args.new_size != 0 && args.count > SIZE_MAX / args.new_size) {
+            *out_error = Allocator_Error_Out_Of_Memory;
+            return NULL;
+        }
+        charged = args.new_size * args.count;
+        break;
+
+    case Allocator_Mode_Resize:
+        if (args.old_ptr == NULL)
+            args.old_size = 0;
+        if (args.new_size > args.old_size)
+            charged = args.new_size - args.old_size;
+        break;
+
+    case Allocator_Mode_Free:
+    case Allocator_Mode_Free_All:
+        break;
+
+    default:
+        assert(false);
+    }
+    if (!_budget_charge(budget, charged)) {
+        *out_error = Allocator_Error_Out_Of_Memory;
+        return NULL;
+    }
+
+    void *data = inner.fn(out_error, inner.user_ptr, mode, args);
+    if (*out_error) {
+        _budget_release(budget, charged);
+        return data;
+    }
+
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+    case Allocator_Mode_Alloc_Zeroed:
+    case Allocator_Mode_Resize:
+        if (mode == Allocator_Mode_Resize && args.new_size < args.old_size)
+            _budget_release(budget, args.old_size - args.new_size);
+
+        // The caller owns, and will later free, the whole usable size. Charge
+        // it even if that goes over: the memory is already taken either way.
+        if (args.out_size != NULL && *args.out_size > args.new_size)
+            atomic_fetch_add_explicit(&budget->used, *args.out_size - args.new_size, memory_order_relaxed);
+        break;
+
+    case Allocator_Mode_Free:
+        if (args.old_ptr != NULL)
+            _budget_release(budget, args.old_size);
+        break;
+
+    case Allocator_Mode_Free_All:
+        atomic_store_explicit(&budget->used, 0, memory_order_relaxed);
+        break;
+
+    default:
+        break;
+    }
+    return data;
+}
+
+Allocator
+budget_allocator(Budget_Allocator *budget)
+{
+    Allocator allocator = {.fn = &_budget_allocator_fn, .user_ptr = budget};
+    return allocator;
+}
+
+#endif // DSA_BUDGET_IMPLEMENTATION
@@ -0,0 +1,583 @@
+#pragma once
+
+#ifdef DSA_IMPLEMENTATION
+#define DSA_CONCURRENT_ALLOCATOR_IMPLEMENTATION
+#endif // DSA_IMPLEMENTATION
+
+#include "../common.h"
+#include "allocator.h"
+
+#include <pthread.h>
+
+#ifndef CONCURRENT_ALLOCATOR_MAGAZINE_SIZE
+// Objects per magazine: how many allocations, or frees, a thread gets through
+// on its own before it has to visit the shared depot.
+#define CONCURRENT_ALLOCATOR_MAGAZINE_SIZE  64
+#endif // CONCURRENT_ALLOCATOR_MAGAZINE_SIZE
+
+#ifndef CONCURRENT_ALLOCATOR_DEPOT_SIZE
+// Full magazines, and empty ones, each depot keeps at most. Past that, full
+// ones go back to the backend and empty ones are freed.
+#define CONCURRENT_ALLOCATOR_DEPOT_SIZE     8
+#endif // CONCURRENT_ALLOCATOR_DEPOT_SIZE
+
+// Size classes are 16, 32, 64... bytes, up to 2 KiB. Anything bigger goes
+// straight to the backend.
+#define CONCURRENT_ALLOCATOR_MIN_SIZE       16
+#define CONCURRENT_ALLOCATOR_CLASS_COUNT    8
+
+typedef struct Concurrent_Magazine Concurrent_Magazine;
+struct Concurrent_Magazine {
+    Concurrent_Magazine *next;  // Only used while in a depot.
+    size_t               count; // `objects[0..count)` are free to hand out.
+    void                *objects[CONCURRENT_ALLOCATOR_MAGAZINE_SIZE];
+};
+
+/**
+ * @brief
+ *      Where threads trade magazines of 1 size class. Each depot has its own
+ *      cache line so that classes do not contend with each other.
+ */
+typedef struct {
+    alignas(64) pthread_mutex_t lock;
+    Concurrent_Magazine        *full;        // Never empty, but not always full.
+    Concurrent_Magazine        *empty;
+    size_t                      full_count;  // Up to `CONCURRENT_ALLOCATOR_DEPOT_SIZE`.
+    size_t                      empty_count; // Likewise.
+} Concurrent_Depot;
+
+typedef struct Concurrent_Cache Concurrent_Cache;
+
+/**
+ * @brief
+ *      Makes any `Allocator` safe to share between threads, and fast to share
+ *      for small objects.
+ *
+ *      Each thread keeps 2 magazines of free objects per size class. Most
+ *      allocations pop from the loaded one and most frees push onto it, with
+ *      no atomics nor locks. Only when both are empty, or both full, does the
+ *      thread lock the depot to trade a whole magazine. An object freed by
+ *      another thread thus travels back in a batch of
+ *      `CONCURRENT_ALLOCATOR_MAGAZINE_SIZE`, e.g. from a consumer thread to
+ *      the producer, at the cost of 1 lock per batch rather than per object.
+ *
+ *      New objects are carved from the backend 1 magazine at a time with
+ *      `mem_rawnew_many`. Requests over 2 KiB go straight to the backend.
+ *      Either way, `backend` is only ever called under `backend_lock`, so it
+ *      need not be thread-safe itself.
+ *
+ * @note
+ *      Each depot holds on to at most `CONCURRENT_ALLOCATOR_DEPOT_SIZE` full
+ *      magazines. A thread which frees past that gives a whole magazine of
+ *      objects back to `backend` in 1 go, so a size class does not keep its
+ *      peak memory forever. Below that, memory freed in 1 size class can only
+ *      be reused by that class.
+ *
+ *      Small objects are aligned to `alignof(max_align_t)`. Like
+ *      `pool_allocator`, stricter alignments are refused unless the object is
+ *      big enough to go to the backend anyway.
+ */
+typedef struct {
+    Concurrent_Depot  depots[CONCURRENT_ALLOCATOR_CLASS_COUNT];
+    Allocator         backend;
+    pthread_mutex_t   backend_lock;
+    pthread_key_t     cache_key;    // The calling thread's `Concurrent_Cache`.
+    Concurrent_Cache *caches;       // Those of all threads, under `backend_lock`.
+} Concurrent_Allocator;
+
+Allocator_Error
+concurrent_allocator_init(Concurrent_Allocator *allocator, Allocator backend);
+
+/**
+ * @brief
+ *      Gives every cached object and magazine back to the backend. Not
+ *      thread-safe: only call it once all other threads are done with
+ *      `allocator`.
+ */
+void
+concurrent_allocator_destroy(Concurrent_Allocator *allocator);
+
+/**
+ * @brief
+ *      Create a stack-allocated `Allocator` instance which any thread may use.
+ *
+ * @note
+ *      `Allocator_Mode_Free_All` is not implemented: other threads may still
+ *      be holding on to their magazines.
+ */
+Allocator
+concurrent_allocator(Concurrent_Allocator *allocator);
+
+#ifdef DSA_CONCURRENT_ALLOCATOR_IMPLEMENTATION
+
+#include <assert.h> // assert
+#include <string.h> // memset, memcpy
+
+struct Concurrent_Cache {
+    Concurrent_Allocator *owner;
+    Concurrent_Cache     *prev;     // Links in `owner->caches`.
+    Concurrent_Cache     *next;
+    Concurrent_Magazine  *loaded[CONCURRENT_ALLOCATOR_CLASS_COUNT];
+    Concurrent_Magazine  *previous[CONCURRENT_ALLOCATOR_CLASS_COUNT];
+};
+
+static void
+_concurrent_cache_release(void *user_ptr);
+
+Allocator_Error
+concurrent_allocator_init(Concurrent_Allocator *allocator, Allocator backend)
+{
+    // Runs `_concurrent_cache_release` for every thread that exits with a cache.
+    if (pthread_key_create(&allocator->cache_key, &_concurrent_cache_release) != 0)
+        return Allocator_Error_Out_Of_Memory;
+
+    for (size_t i = 0; i < CONCURRENT_ALLOCATOR_CLASS_COUNT; ++i) {
+        Concurrent_Depot *depot = &allocator->depots[i];
+        pthread_mutex_init(&depot->lock, NULL);
+        depot->full        = NULL;
+        depot->empty       = NULL;
+        depot->full_count  = 0;
+        depot->empty_count = 0;
+    }
+    allocator->backend = backend;
+    allocator->caches  = NULL;
+    pthread_mutex_init(&allocator->backend_lock, NULL);
+    return Allocator_Error_None;
+}
+
+static size_t
+_concurrent_size_class(size_t size)
+{
+    size_t index = 0;
+    for (size_t limit = CONCURRENT_ALLOCATOR_MIN_SIZE; size > limit && index < CONCURRENT_ALLOCATOR_CLASS_COUNT; limit <<= 1)
+        ++index;
+    return index;
+}
+
+static void *
+_concurrent_backend_fn(Concurrent_Allocator *allocator, Allocator_Error *out_error, Allocator_Mode mode, Allocator_Args args)
+{
+    Allocator backend = allocator->backend;
+    pthread_mutex_lock(&allocator->backend_lock);
+    void *data = backend.fn(out_error, backend.user_ptr, mode, args);
+    pthread_mutex_unlock(&allocator->backend_lock);
+    return data;
+}
+
+static Concurrent_Magazine *
+_concurrent_magazine_new(Concurrent_Allocator *allocator, Allocator_Error *out_error)
+{
+    pthread_mutex_lock(&allocator->backend_lock);
+    Concurrent_Magazine *magazine = mem_new(Concurrent_Magazine, out_error, allocator->backend);
+    pthread_mutex_unlock(&allocator->backend_lock);
+    if (*out_error)
+        return NULL;
+    magazine->next  = NULL;
+    magazine->count = 0;
+    return magazine;
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Give all of the objects in `magazine`
+ *      back to the backend at once, leaving it empty.
+ */
+static void
+_concurrent_magazine_drain(Concurrent_Allocator *allocator, Concurrent_Magazine *magazine, size_t index)
+{
+    size_t size = cast(size_t)CONCURRENT_ALLOCATOR_MIN_SIZE << index;
+    pthread_mutex_lock(&allocator->backend_lock);
+    for (size_t i = 0; i < magazine->count; ++i)
+        mem_rawfree(magazine->objects[i], size, allocator->backend);
+    pthread_mutex_unlock(&allocator->backend_lock);
+    magazine->count = 0;
+}
+
+static void
+_concurrent_magazine_destroy(Concurrent_Allocator *allocator, Concurrent_Magazine *magazine, size_t index)
+{
+    _concurrent_magazine_drain(allocator, magazine, index);
+    pthread_mutex_lock(&allocator->backend_lock);
+    mem_free(magazine, allocator->backend);
+    pthread_mutex_unlock(&allocator->backend_lock);
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Put `magazine` on the right list of
+ *      `depot` if there is room. The caller holds `depot->lock`.
+ *
+ * @return
+ *      `false` if `depot` already has enough such magazines.
+ */
+static bool
+_concurrent_depot_keep(Concurrent_Depot *depot, Concurrent_Magazine *magazine)
+{
+    if (magazine->count == 0) {
+        if (depot->empty_count >= CONCURRENT_ALLOCATOR_DEPOT_SIZE)
+            return false;
+        magazine->next = depot->empty;
+        depot->empty   = magazine;
+        depot->empty_count++;
+    } else {
+        if (depot->full_count >= CONCURRENT_ALLOCATOR_DEPOT_SIZE)
+            return false;
+        magazine->next = depot->full;
+        depot->full    = magazine;
+        depot->full_count++;
+    }
+    return true;
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Hand `magazine`, in whatever state,
+ *      over to the depot of class `index`, or destroy it if it has no room.
+ */
+static void
+_concurrent_depot_push(Concurrent_Allocator *allocator, size_t index, Concurrent_Magazine *magazine)
+{
+    if (magazine == NULL)
+        return;
+    Concurrent_Depot *depot = &allocator->depots[index];
+    pthread_mutex_lock(&depot->lock);
+    bool kept = _concurrent_depot_keep(depot, magazine);
+    pthread_mutex_unlock(&depot->lock);
+    if (!kept)
+        _concurrent_magazine_destroy(allocator, magazine, index);
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Get the calling thread's cache,
+ *      creating it on first use.
+ */
+static Concurrent_Cache *
+_concurrent_cache_get(Concurrent_Allocator *allocator, Allocator_Error *out_error)
+{
+    Concurrent_Cache *cache = cast(Concurrent_Cache *)pthread_getspecific(allocator->cache_key);
+    if (cache != NULL)
+        return cache;
+
+    pthread_mutex_lock(&allocator->backend_lock);
+    cache = mem_make_zeroed(Concurrent_Cache, out_error, 1, allocator->backend);
+    if (!*out_error) {
+        cache->owner = allocator;
+        cache->next  = allocator->caches;
+        if (cache->next != NULL)
+            cache->next->prev = cache;
+        allocator->caches = cache;
+    }
+    pthread_mutex_unlock(&allocator->backend_lock);
+    if (*out_error)
+        return NULL;
+
+    pthread_setspecific(allocator->cache_key, cache);
+    return cache;
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Move all of the magazines of `cache`
+ *      to the depots, leaving it empty.
+ */
+static void
+_concurrent_cache_flush(Concurrent_Allocator *allocator, Concurrent_Cache *cache)
+{
+    for (size_t i = 0; i < CONCURRENT_ALLOCATOR_CLASS_COUNT; ++i) {
+        _concurrent_depot_push(allocator, i, cache->loaded[i]);
+        _concurrent_depot_push(allocator, i, cache->previous[i]);
+        cache->loaded[i]   = NULL;
+        cache->previous[i] = NULL;
+    }
+}
+
+static void
+_concurrent_cache_release(void *user_ptr)
+{
+    Concurrent_Cache     *cache     = cast(Concurrent_Cache *)user_ptr;
+    Concurrent_Allocator *allocator = cache->owner;
+    _concurrent_cache_flush(allocator, cache);
+
+    pthread_mutex_lock(&allocator->backend_lock);
+    if (cache->prev != NULL)
+        cache->prev->next = cache->next;
+    else
+        allocator->caches = cache->next;
+    if (cache->next != NULL)
+        cache->next->prev = cache->prev;
+    mem_free(cache, allocator->backend);
+    pthread_mutex_unlock(&allocator->backend_lock);
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Refill the loaded magazine of class
+ *      `index`, which is empty, and pop 1 object off of it.
+ */
+static void *
+_concurrent_rawalloc_slow(Concurrent_Allocator *allocator, Concurrent_Cache *cache, size_t index, Allocator_Error *out_error)
+{
+    Concurrent_Magazine **loaded   = &cache->loaded[index];
+    Concurrent_Magazine **previous = &cache->previous[index];
+    *out_error = Allocator_Error_None;
+
+    // 1. The other magazine may still have some.
+    if (*previous != NULL && (*previous)->count > 0) {
+        Concurrent_Magazine *tmp = *loaded;
+        *loaded   = *previous;
+        *previous = tmp;
+        return (*loaded)->objects[--(*loaded)->count];
+    }
+
+    // 2. Both are empty: trade 1 of them for a full one, e.g. filled by
+    // another thread freeing what we allocated earlier.
+    Concurrent_Depot    *depot = &allocator->depots[index];
+    Concurrent_Magazine *spare = NULL;
+    pthread_mutex_lock(&depot->lock);
+    Concurrent_Magazine *full = depot->full;
+    if (full != NULL) {
+        depot->full = full->next;
+        depot->full_count--;
+        if (*previous != NULL && !_concurrent_depot_keep(depot, *previous))
+            spare = *previous;
+        *previous = *loaded;
+        *loaded   = full;
+    } else if (*loaded == NULL && depot->empty != NULL) {
+        *loaded      = depot->empty;
+        depot->empty = (*loaded)->next;
+        depot->empty_count--;
+    }
+    pthread_mutex_unlock(&depot->lock);
+    if (spare != NULL)
+        _concurrent_magazine_destroy(allocator, spare, index);
+
+    // 3. Nobody has any to give back: fill the loaded magazine from scratch.
+    if (full == NULL) {
+        if (*loaded == NULL) {
+            *loaded = _concurrent_magazine_new(allocator, out_error);
+            if (*out_error)
+                return NULL;
+        }
+        pthread_mutex_lock(&allocator->backend_lock);
+        mem_rawnew_many(
+            out_error,
+            (*loaded)->objects,
+            CONCURRENT_ALLOCATOR_MAGAZINE_SIZE,
+            cast(size_t)CONCURRENT_ALLOCATOR_MIN_SIZE << index,
+            alignof(max_align_t),
+            allocator->backend,
+            SOURCE_LOCATION);
+        pthread_mutex_unlock(&allocator->backend_lock);
+        if (*out_error)
+            return NULL;
+        (*loaded)->count = CONCURRENT_ALLOCATOR_MAGAZINE_SIZE;
+    }
+    return (*loaded)->objects[--(*loaded)->count];
+}
+
+static inline void *
+_concurrent_rawalloc(Concurrent_Allocator *allocator, size_t index, Allocator_Error *out_error)
+{
+    Concurrent_Cache *cache = _concurrent_cache_get(allocator, out_error);
+    if (cache == NULL)
+        return NULL;
+
+    Concurrent_Magazine *loaded = cache->loaded[index];
+    if (loaded != NULL && loaded->count > 0) {
+        *out_error = Allocator_Error_None;
+        return loaded->objects[--loaded->count];
+    }
+    return _concurrent_rawalloc_slow(allocator, cache, index, out_error);
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Make room in the loaded magazine of
+ *      class `index`, which is full, and push `ptr` onto it.
+ */
+static void
+_concurrent_rawfree_slow(Concurrent_Allocator *allocator, Concurrent_Cache *cache, size_t index, void *ptr)
+{
+    Concurrent_Magazine **loaded   = &cache->loaded[index];
+    Concurrent_Magazine **previous = &cache->previous[index];
+
+    // 1. The other magazine may still have room.
+    if (*previous != NULL && (*previous)->count < CONCURRENT_ALLOCATOR_MAGAZINE_SIZE) {
+        Concurrent_Magazine *tmp = *loaded;
+        *loaded   = *previous;
+        *previous = tmp;
+        (*loaded)->objects[(*loaded)->count++] = ptr;
+        return;
+    }
+
+    // 2. Both are full: hand 1 of them over to whoever allocates next, and
+    // trade it for an empty one. If the depot has enough full ones already,
+    // give its objects back to the backend instead and keep it.
+    Concurrent_Depot    *depot = &allocator->depots[index];
+    Concurrent_Magazine *spare = *previous;
+    Concurrent_Magazine *empty = NULL;
+    pthread_mutex_lock(&depot->lock);
+    if (spare != NULL && _concurrent_depot_keep(depot, spare))
+        spare = NULL;
+    if (spare == NULL && depot->empty != NULL) {
+        empty        = depot->empty;
+        depot->empty = empty->next;
+        depot->empty_count--;
+    }
+    pthread_mutex_unlock(&depot->lock);
+
+    if (spare != NULL) {
+        _concurrent_magazine_drain(allocator, spare, index);
+        empty = spare;
+    }
+    *previous = *loaded;
+    *loaded   = empty;
+    if (*loaded == NULL) {
+        Allocator_Error error;
+        *loaded = _concurrent_magazine_new(allocator, &error);
+        if (error) {
+            // Nowhere to keep it; at least it is not lost.
+            pthread_mutex_lock(&allocator->backend_lock);
+            mem_rawfree(ptr, cast(size_t)CONCURRENT_ALLOCATOR_MIN_SIZE << index, allocator->backend);
+            pthread_mutex_unlock(&allocator->backend_lock);
+            return;
+        }
+    }
+    (*loaded)->objects[(*loaded)->count++] = ptr;
+}
+
+static inline void
+_concurrent_rawfree(Concurrent_Allocator *allocator, size_t index, void *ptr)
+{
+    Allocator_Error   error;
+    Concurrent_Cache *cache = _concurrent_cache_get(allocator, &error);
+    if (cache == NULL) {
+        pthread_mutex_lock(&allocator->backend_lock);
+        mem_rawfree(ptr, cast(size_t)CONCURRENT_ALLOCATOR_MIN_SIZE << index, allocator->backend);
+        pthread_mutex_unlock(&allocator->backend_lock);
+        return;
+    }
+
+    Concurrent_Magazine *loaded = cache->loaded[index];
+    if (loaded != NULL && loaded->count < CONCURRENT_ALLOCATOR_MAGAZINE_SIZE) {
+        loaded->objects[loaded->count++] = ptr;
+        return;
+    }
+    _concurrent_rawfree_slow(allocator, cache, index, ptr);
+}
+
+static void *
+_concurrent_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Concurrent_Allocator *allocator = cast(Concurrent_Allocator *)user_ptr;
+    size_t                index     = CONCURRENT_ALLOCATOR_CLASS_COUNT;
+    void                 *data      = NULL;
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+    case Allocator_Mode_Alloc_Zeroed:
+        index = _concurrent_size_class(args.new_size);
+        if (index == CONCURRENT_ALLOCATOR_CLASS_COUNT)
+            return _concurrent_backend_fn(allocator, out_error, mode, args);
+        if (args.alignment > alignof(max_align_t)) {
+            *out_error = Allocator_Error_Out_Of_Memory;
+            return NULL;
+        }
+
+        data = _concurrent_rawalloc(allocator, index, out_error);
+        if (*out_error)
+            return NULL;
+        // Recycled objects are dirty.
+        if (mode == Allocator_Mode_Alloc_Zeroed)
+            memset(data, 0, args.new_size);
+        if (args.out_size != NULL)
+            *args.out_size = cast(size_t)CONCURRENT_ALLOCATOR_MIN_SIZE << index;
+        return data;
+
+    case Allocator_Mode_Resize: {
+        if (args.old_ptr == NULL)
+            return _concurrent_allocator_fn(out_error, user_ptr, Allocator_Mode_Alloc, args);
+
+        size_t old_index = _concurrent_size_class(args.old_size);
+        index = _concurrent_size_class(args.new_size);
+        if (old_index == index && args.alignment <= alignof(max_align_t)) {
+            // Same class, or both too big for any.
+            if (index == CONCURRENT_ALLOCATOR_CLASS_COUNT)
+                return _concurrent_backend_fn(allocator, out_error, mode, args);
+            *out_error = Allocator_Error_None;
+            if (args.out_size != NULL)
+                *args.out_size = cast(size_t)CONCURRENT_ALLOCATOR_MIN_SIZE << index;
+            return args.old_ptr;
+        }
+
+        data = _concurrent_allocator_fn(out_error, user_ptr, Allocator_Mode_Alloc, args);
+        if (*out_error)
+            return NULL;
+        memcpy(data, args.old_ptr, (args.old_size < args.new_size) ? args.old_size : args.new_size);
+        args.out_size = NULL;
+        _concurrent_allocator_fn(out_error, user_ptr, Allocator_Mode_Free, args);
+        *out_error = Allocator_Error_None;
+        return data;
+    }
+
+    case Allocator_Mode_Free:
+        if (args.old_ptr == NULL) {
+            *out_error = Allocator_Error_None;
+            return NULL;
+        }
+        index = _concurrent_size_class(args.old_size);
+        if (index == CONCURRENT_ALLOCATOR_CLASS_COUNT)
+            return _concurrent_backend_fn(allocator, out_error, mode, args);
+        _concurrent_rawfree(allocator, index, args.old_ptr);
+        *out_error = Allocator_Error_None;
+        return NULL;
+
+    // Other threads' magazines are out of reach.
+    case Allocator_Mode_Free_All:
+    // The loop in `mem_rawnew_many` is as good as it gets: every object comes
+    // out of a magazine either way.
+    case Allocator_Mode_Alloc_Many:
+        *out_error = Allocator_Error_Mode_Not_Implemented;
+        return NULL;
+
+    default:
+        assert(false);
+    }
+    return NULL;
+}
+
+Allocator
+concurrent_allocator(Concurrent_Allocator *allocator)
+{
+    Allocator result = {.fn = &_concurrent_allocator_fn, .user_ptr = allocator};
+    return result;
+}
+
+void
+concurrent_allocator_destroy(Concurrent_Allocator *allocator)
+{
+    // No more `_concurrent_cache_release` from threads exiting after this.
+    pthread_key_delete(allocator->cache_key);
+    while (allocator->caches != NULL) {
+        Concurrent_Cache *cache = allocator->caches;
+        allocator->caches = cache->next;
+        _concurrent_cache_flush(allocator, cache);
+        mem_free(cache, allocator->backend);
+    }
+
+    for (size_t i = 0; i < CONCURRENT_ALLOCATOR_CLASS_COUNT; ++i) {
+        Concurrent_Depot *depot = &allocator->depots[i];
+        for (Concurrent_Magazine *it = depot->full, *next; it != NULL; it = next) {
+            next = it->next;
+            _concurrent_magazine_destroy(allocator, it, i);
+        }
+        for (Concurrent_Magazine *it = depot->empty, *next; it != NULL; it = next) {
+            next = it->next;
+            _concurrent_magazine_destroy(allocator, it, i);
+        }
+        pthread_mutex_destroy(&depot->lock);
+    }
+    pthread_mutex_destroy(&allocator->backend_lock);
+}
+
+#endif // DSA_CONCURRENT_ALLOCATOR_IMPLEMENTATION
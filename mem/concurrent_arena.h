@@ -0,0 +1,383 @@
+#pragma once
+
+#ifdef DSA_IMPLEMENTATION
+#define DSA_CONCURRENT_ARENA_IMPLEMENTATION
+#endif // DSA_IMPLEMENTATION
+
+#include "../common.h"
+#include "allocator.h"
+
+#include <stdatomic.h>
+
+#ifndef CONCURRENT_ARENA_BLOCK_SIZE
+// Size of the first block, header included. Later blocks double in size up to
+// `CONCURRENT_ARENA_MAX_BLOCK_SIZE`.
+#define CONCURRENT_ARENA_BLOCK_SIZE     (1 << 16)
+#endif // CONCURRENT_ARENA_BLOCK_SIZE
+
+#ifndef CONCURRENT_ARENA_MAX_BLOCK_SIZE
+#define CONCURRENT_ARENA_MAX_BLOCK_SIZE (1 << 22)
+#endif // CONCURRENT_ARENA_MAX_BLOCK_SIZE
+
+// Every allocation is rounded up to a multiple of this, so that the fast path
+// can hand out aligned memory with nothing but a fetch-add.
+#define CONCURRENT_ARENA_GRANULE        alignof(max_align_t)
+
+typedef struct Concurrent_Block Concurrent_Block;
+struct Concurrent_Block {
+    Concurrent_Block *prev; // The previous block, likely filled up.
+    _Atomic(size_t)   used; // May overshoot `size` once the block is full.
+    size_t            size; // The total number of bytes in `base`.
+    alignas(max_align_t) char base[];
+};
+
+/**
+ * @brief
+ *      An arena that may be allocated from by any number of threads at once.
+ *
+ * @note
+ *      The fast path is a single `atomic_fetch_add` on `begin->used`. Whoever
+ *      overshoots the end of the block takes the slow path: it allocates a new
+ *      block, takes its own allocation out of it, then tries to install it as
+ *      `begin` with a compare-and-swap. If another thread got there first, the
+ *      new block is thrown away and the allocation is retried on the winner's.
+ *
+ *      Allocations too big to be worth a shared block get a block of their own,
+ *      pushed onto `large` instead.
+ *
+ *      Blocks are never freed while the arena is in use, so a thread holding an
+ *      old `begin` can never touch freed memory. `concurrent_arena_free_all()`
+ *      and `concurrent_arena_destroy()` are thus NOT thread-safe: only call them
+ *      once all other threads are done with the arena.
+ */
+typedef struct {
+    _Atomic(Concurrent_Block *) begin; // Block all threads are bumping.
+    _Atomic(Concurrent_Block *) large; // Dedicated blocks for big allocations.
+} Concurrent_Arena;
+
+/**
+ * @brief
+ *      Initializes `arena` with 1 block of `CONCURRENT_ARENA_BLOCK_SIZE`.
+ */
+Allocator_Error
+concurrent_arena_init(Concurrent_Arena *arena);
+
+/**
+ * @brief
+ *      Frees all the blocks owned by `arena`. Not thread-safe.
+ */
+void
+concurrent_arena_destroy(Concurrent_Arena *arena);
+
+/**
+ * @brief
+ *      Allocate `size` bytes aligned to `align` from `arena`. Thread-safe.
+ *
+ * @return
+ *      `NULL` if a new block was needed but could not be allocated.
+ */
+void *
+concurrent_arena_rawalloc(Concurrent_Arena *arena, size_t size, size_t align);
+
+/**
+ * @brief
+ *      Extend `old_ptr` in place if it is still the most recent allocation
+ *      of its block, otherwise allocate and copy. Thread-safe, as long as no
+ *      two threads resize the same pointer.
+ */
+void *
+concurrent_arena_rawresize(Concurrent_Arena *arena, void *old_ptr, size_t old_size, size_t new_size, size_t align);
+
+/**
+ * @brief
+ *      Keep the newest block and free the rest. Not thread-safe.
+ */
+void
+concurrent_arena_free_all(Concurrent_Arena *arena);
+
+/**
+ * @brief
+ *      Get the number of bytes allocated so far, and optionally the total
+ *      capacity, across all blocks. Only exact when no thread is allocating.
+ */
+size_t
+concurrent_arena_get_usage(Concurrent_Arena *arena, size_t *out_total);
+
+/**
+ * @brief
+ *      Create a stack-allocated `Allocator` instance out of a
+ *      `Concurrent_Arena *`. Copies of it may be shared between threads.
+ */
+Allocator
+concurrent_arena_allocator(Concurrent_Arena *arena);
+
+#ifdef DSA_CONCURRENT_ARENA_IMPLEMENTATION
+
+#include <assert.h> // assert
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcpy
+
+static Concurrent_Block *
+_concurrent_block_new(size_t size, Concurrent_Block *prev)
+{
+    Concurrent_Block *block = cast(Concurrent_Block *)malloc(size);
+    if (block != NULL) {
+        block->prev = prev;
+        block->size = size - sizeof(*block);
+        atomic_init(&block->used, 0);
+    }
+    return block;
+}
+
+static void
+_concurrent_block_free_chain(Concurrent_Block *block)
+{
+    while (block != NULL) {
+        Concurrent_Block *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+}
+
+/**
+ * @brief
+ *      Internal implementation function. How many bytes to reserve in a block
+ *      so that an allocation of `size` can be aligned to `align` anywhere in it.
+ *
+ * @return
+ *      0 on overflow.
+ */
+static inline size_t
+_concurrent_arena_padded_size(size_t size, size_t align)
+{
+    assert(align != 0 && (align & (align - 1)) == 0);
+    size_t extra  = (align > CONCURRENT_ARENA_GRANULE) ? align - CONCURRENT_ARENA_GRANULE : 0;
+    size_t padded = (size + extra + (CONCURRENT_ARENA_GRANULE - 1)) & ~(CONCURRENT_ARENA_GRANULE - 1);
+    return (padded >= size) ? padded : 0;
+}
+
+static inline void *
+_concurrent_arena_align(char *start, size_t align)
+{
+    uintptr_t addr = cast(uintptr_t)start;
+    return cast(void *)((addr + (align - 1)) & ~cast(uintptr_t)(align - 1));
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Bump `block` by `padded` bytes.
+ *
+ * @return
+ *      `NULL` if the block is full. It stays full; `used` is never rolled back
+ *      since other threads may have bumped it in the meantime.
+ */
+static inline void *
+_concurrent_block_rawalloc(Concurrent_Block *block, size_t padded, size_t align)
+{
+    size_t offset = atomic_fetch_add_explicit(&block->used, padded, memory_order_relaxed);
+    if (offset <= block->size && padded <= block->size - offset)
+        return _concurrent_arena_align(block->base + offset, align);
+    return NULL;
+}
+
+static void *
+_concurrent_arena_alloc_large(Concurrent_Arena *arena, size_t padded, size_t align)
+{
+    Concurrent_Block *block = _concurrent_block_new(sizeof(*block) + padded, NULL);
+    if (block == NULL)
+        return NULL;
+    atomic_store_explicit(&block->used, padded, memory_order_relaxed);
+
+    // Push-only, so there is no ABA problem.
+    Concurrent_Block *head = atomic_load_explicit(&arena->large, memory_order_relaxed);
+    do {
+        block->prev = head;
+    } while (!atomic_compare_exchange_weak_explicit(&arena->large, &head, block,
+        memory_order_release, memory_order_relaxed));
+    return _concurrent_arena_align(block->base, align);
+}
+
+static void *
+_concurrent_arena_rawalloc_slow(Concurrent_Arena *arena, Concurrent_Block *full, size_t padded, size_t align)
+{
+    for (;;) {
+        size_t size = full->size + sizeof(*full);
+        if (size < CONCURRENT_ARENA_MAX_BLOCK_SIZE)
+            size *= 2;
+        while (size - sizeof(*full) < padded)
+            size *= 2;
+
+        // Take our allocation out of the new block before anyone else can see it.
+        Concurrent_Block *block = _concurrent_block_new(size, full);
+        if (block == NULL)
+            return NULL;
+        atomic_store_explicit(&block->used, padded, memory_order_relaxed);
+
+        if (atomic_compare_exchange_strong_explicit(&arena->begin, &full, block,
+            memory_order_acq_rel, memory_order_acquire))
+            return _concurrent_arena_align(block->base, align);
+
+        // Lost the race; `full` is now whatever the winner installed.
+        free(block);
+        void *data = _concurrent_block_rawalloc(full, padded, align);
+        if (data != NULL)
+            return data;
+    }
+}
+
+void *
+concurrent_arena_rawalloc(Concurrent_Arena *arena, size_t size, size_t align)
+{
+    size_t padded = _concurrent_arena_padded_size(size, align);
+    if (padded == 0 && size != 0)
+        return NULL;
+
+    // Big allocations would waste most of a shared block, or not fit at all.
+    if (padded > CONCURRENT_ARENA_MAX_BLOCK_SIZE / 4)
+        return _concurrent_arena_alloc_large(arena, padded, align);
+
+    Concurrent_Block *block = atomic_load_explicit(&arena->begin, memory_order_acquire);
+    void             *data  = _concurrent_block_rawalloc(block, padded, align);
+    if (data != NULL)
+        return data;
+    return _concurrent_arena_rawalloc_slow(arena, block, padded, align);
+}
+
+void *
+concurrent_arena_rawresize(Concurrent_Arena *arena, void *old_ptr, size_t old_size, size_t new_size, size_t align)
+{
+    if (old_ptr == NULL)
+        return concurrent_arena_rawalloc(arena, new_size, align);
+    if (new_size <= old_size)
+        return old_ptr;
+
+    // Only the current block can be extended. If nobody has allocated after us
+    // the CAS succeeds and we simply take some more of it. Over-aligned
+    // allocations may not start where their reservation does, so skip those.
+    Concurrent_Block *block  = atomic_load_explicit(&arena->begin, memory_order_acquire);
+    char             *start  = cast(char *)old_ptr;
+    size_t            padded = _concurrent_arena_padded_size(old_size, align);
+    if (align <= CONCURRENT_ARENA_GRANULE && start >= block->base && start < block->base + block->size) {
+        size_t offset = cast(size_t)(start - block->base);
+        size_t used   = offset + padded;
+        size_t want   = offset + _concurrent_arena_padded_size(new_size, align);
+        if (want > used && want <= block->size
+            && atomic_compare_exchange_strong_explicit(&block->used, &used, want,
+                memory_order_relaxed, memory_order_relaxed))
+            return old_ptr;
+    }
+
+    void *data = concurrent_arena_rawalloc(arena, new_size, align);
+    if (data != NULL)
+        memcpy(data, old_ptr, old_size);
+    return data;
+}
+
+static void *
+_concurrent_arena_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Concurrent_Arena *arena = cast(Concurrent_Arena *)user_ptr;
+    void             *data  = NULL;
+    *out_error = Allocator_Error_None;
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+    case Allocator_Mode_Resize:
+        if (mode == Allocator_Mode_Alloc)
+            data = concurrent_arena_rawalloc(arena, args.new_size, args.alignment);
+        else
+            data = concurrent_arena_rawresize(arena, args.old_ptr, args.old_size, args.new_size, args.alignment);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        // The rounding up to `CONCURRENT_ARENA_GRANULE` is ours to use.
+        else if (args.out_size != NULL && args.alignment <= CONCURRENT_ARENA_GRANULE)
+            *args.out_size = _concurrent_arena_padded_size(args.new_size, args.alignment);
+        break;
+
+    // 1 atomic bump for the lot, contiguous like `arena_rawalloc_many`.
+    case Allocator_Mode_Alloc_Many: {
+        size_t stride = (args.new_size + (args.alignment - 1)) & ~(args.alignment - 1);
+        if (stride != 0 && args.count > SIZE_MAX / stride) {
+            *out_error = Allocator_Error_Out_Of_Memory;
+            break;
+        }
+        data = concurrent_arena_rawalloc(arena, stride * args.count, args.alignment);
+        if (data == NULL) {
+            *out_error = Allocator_Error_Out_Of_Memory;
+            break;
+        }
+        for (size_t i = 0; i < args.count; ++i)
+            args.out_ptrs[i] = cast(char *)data + i * stride;
+        break;
+    }
+
+    // Blocks come from `malloc` and get reused, so we know nothing better
+    // than `memset`. Let the caller do it.
+    case Allocator_Mode_Alloc_Zeroed:
+    case Allocator_Mode_Free:
+        *out_error = Allocator_Error_Mode_Not_Implemented;
+        break;
+
+    case Allocator_Mode_Free_All:
+        concurrent_arena_free_all(arena);
+        break;
+
+    default:
+        assert(false);
+    }
+    return data;
+}
+
+Allocator_Error
+concurrent_arena_init(Concurrent_Arena *arena)
+{
+    Concurrent_Block *block = _concurrent_block_new(CONCURRENT_ARENA_BLOCK_SIZE, NULL);
+    if (block == NULL)
+        return Allocator_Error_Out_Of_Memory;
+    atomic_init(&arena->begin, block);
+    atomic_init(&arena->large, NULL);
+    return Allocator_Error_None;
+}
+
+void
+concurrent_arena_destroy(Concurrent_Arena *arena)
+{
+    _concurrent_block_free_chain(atomic_exchange(&arena->begin, NULL));
+    _concurrent_block_free_chain(atomic_exchange(&arena->large, NULL));
+}
+
+void
+concurrent_arena_free_all(Concurrent_Arena *arena)
+{
+    Concurrent_Block *begin = atomic_load(&arena->begin);
+    _concurrent_block_free_chain(begin->prev);
+    _concurrent_block_free_chain(atomic_exchange(&arena->large, NULL));
+    begin->prev = NULL;
+    atomic_store(&begin->used, 0);
+}
+
+size_t
+concurrent_arena_get_usage(Concurrent_Arena *arena, size_t *out_total)
+{
+    Concurrent_Block *chains[] = {atomic_load(&arena->begin), atomic_load(&arena->large)};
+    size_t            usage    = 0;
+    size_t            total    = 0;
+    for (size_t i = 0; i < count_of(chains); ++i) {
+        for (Concurrent_Block *block = chains[i]; block != NULL; block = block->prev) {
+            size_t used = atomic_load_explicit(&block->used, memory_order_relaxed);
+            usage += (used < block->size) ? used : block->size;
+            total += block->size;
+        }
+    }
+    if (out_total != NULL)
+        *out_total = total;
+    return usage;
+}
+
+Allocator
+concurrent_arena_allocator(Concurrent_Arena *arena)
+{
+    Allocator allocator = {.fn = &_concurrent_arena_allocator_fn, .user_ptr = arena};
+    return allocator;
+}
+
+#endif // DSA_CONCURRENT_ARENA_IMPLEMENTATION
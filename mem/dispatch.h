@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../common.h"
+#include "allocator.h"
+#include "arena.h"
+#include "pool.h"
+
+/**
+ * @brief
+ *      Statically dispatched versions of the `mem_*` macros. Instead of an
+ *      `Allocator`, pass the backing allocator itself, e.g. an `Arena *`, and
+ *      `_Generic` picks its fast path at compile time. The arena bump and the
+ *      pool free list pop are then inlined right into the caller, where the
+ *      `Allocator` interface would always make an indirect call.
+ *
+ *      Anything else that is an `Allocator` still works and goes through
+ *      `Allocator.fn` as usual, so code can switch over 1 call at a time:
+ *
+ *  ```c
+ *          Arena *arena = ...;
+ *          int   *a     = mem_new(int, &error, arena_allocator(arena)); // Indirect call.
+ *          int   *b     = mem_new_static(int, &error, arena);           // Inlined.
+ *  ```
+ *
+ * @note
+ *      Only `Allocator.fn` is bypassed. Wrappers such as `Tracking_Allocator`
+ *      only see what goes through it.
+ *
+ *      C++ code should use `mem/allocator.hpp` instead.
+ */
+#define mem_new_static(T, out_error, backing)                                  \
+    cast(T *)_mem_static_rawnew(                                               \
+        out_error,                                                             \
+        sizeof(T),                                                             \
+        alignof(T),                                                            \
+        backing)
+
+#define mem_make_static(T, out_error, count, backing)                          \
+    cast(T *)_mem_static_rawnew(                                               \
+        out_error,                                                             \
+        sizeof(T) * (count),                                                   \
+        alignof(T),                                                            \
+        backing)
+
+#define mem_free_static(ptr, backing)                                          \
+    _mem_static_rawfree(                                                       \
+        ptr,                                                                   \
+        sizeof(*(ptr)),                                                        \
+        backing)
+
+#define mem_delete_static(ptr, count, backing)                                 \
+    _mem_static_rawfree(                                                       \
+        ptr,                                                                   \
+        sizeof(*(ptr)) * (count),                                              \
+        backing)
+
+#define _mem_static_rawnew(out_error, size, align, backing)                    \
+    _Generic((backing),                                                        \
+        Arena *:   _mem_static_rawnew_arena,                                   \
+        Pool *:    _mem_static_rawnew_pool,                                    \
+        Allocator: _mem_static_rawnew_allocator                                \
+    )(out_error, size, align, backing, SOURCE_LOCATION)
+
+#define _mem_static_rawfree(ptr, size, backing)                                \
+    _Generic((backing),                                                        \
+        Arena *:   _mem_static_rawfree_arena,                                  \
+        Pool *:    _mem_static_rawfree_pool,                                   \
+        Allocator: _mem_static_rawfree_allocator                               \
+    )(ptr, size, backing, SOURCE_LOCATION)
+
+//=== ARENA ================================================================ {{{
+
+static inline void *
+_mem_static_rawnew_arena(Allocator_Error *out_error, size_t size, size_t align, Arena *arena, Source_Location location)
+{
+    unused(location);
+    void *data = arena_rawalloc_inline(arena, size, align);
+    *out_error = (data != NULL) ? Allocator_Error_None : Allocator_Error_Out_Of_Memory;
+    return data;
+}
+
+static inline Allocator_Error
+_mem_static_rawfree_arena(void *ptr, size_t size, Arena *arena, Source_Location location)
+{
+    // Same answer as `arena_allocator`.
+    unused(ptr);
+    unused(size);
+    unused(arena);
+    unused(location);
+    return Allocator_Error_Mode_Not_Implemented;
+}
+
+//=== }}} ======================================================================
+
+//=== POOL ================================================================= {{{
+
+static inline void *
+_mem_static_rawnew_pool(Allocator_Error *out_error, size_t size, size_t align, Pool *pool, Source_Location location)
+{
+    unused(location);
+    // Same limits as `pool_allocator`.
+    void *data = NULL;
+    if (size <= pool->chunk_size && align <= pool->chunk_align)
+        data = pool_rawalloc_inline(pool);
+    *out_error = (data != NULL) ? Allocator_Error_None : Allocator_Error_Out_Of_Memory;
+    return data;
+}
+
+static inline Allocator_Error
+_mem_static_rawfree_pool(void *ptr, size_t size, Pool *pool, Source_Location location)
+{
+    unused(size);
+    unused(location);
+    pool_rawfree(pool, ptr);
+    return Allocator_Error_None;
+}
+
+//=== }}} ======================================================================
+
+//=== DYNAMIC FALLBACK ===================================================== {{{
+
+static inline void *
+_mem_static_rawnew_allocator(Allocator_Error *out_error, size_t size, size_t align, Allocator allocator, Source_Location location)
+{
+    return mem_rawnew_loc(out_error, size, align, allocator, location);
+}
+
+static inline Allocator_Error
+_mem_static_rawfree_allocator(void *ptr, size_t size, Allocator allocator, Source_Location location)
+{
+    return mem_rawfree_loc(ptr, size, allocator, location);
+}
+
+//=== }}} ======================================================================
@@ -0,0 +1,393 @@
+#pragma once
+
+#ifdef DSA_IMPLEMENTATION
+#define DSA_POOL_IMPLEMENTATION
+#endif // DSA_IMPLEMENTATION
+
+#include "../common.h"
+#include "allocator.h"
+
+#ifndef POOL_SLAB_SIZE
+// Size of each slab, header included.
+#define POOL_SLAB_SIZE  (1 << 14)
+#endif // POOL_SLAB_SIZE
+
+typedef struct Pool_Slab Pool_Slab;
+struct Pool_Slab {
+    Pool_Slab *prev; // The previous slab, likely filled up.
+    size_t     size; // The total number of bytes in `base`.
+    alignas(max_align_t) char base[];
+};
+
+// Freed chunks are chained through their own first bytes.
+typedef struct Pool_Chunk Pool_Chunk;
+struct Pool_Chunk {
+    Pool_Chunk *next;
+};
+
+/**
+ * @brief
+ *      Hands out chunks of 1 fixed size, carved out of large slabs.
+ *      Allocation and freeing are both O(1) and have no per-chunk header.
+ *
+ * @note
+ *      Freed chunks go on the intrusive `free_list` and are reused first.
+ *      Otherwise we take the next never-used chunk of the newest slab, so
+ *      a fresh slab costs nothing until it is actually used.
+ */
+typedef struct {
+    Pool_Slab  *slabs;       // Newest slab first, chained through `prev`.
+    Pool_Chunk *free_list;   // Freed chunks ready for reuse.
+    char       *cursor;      // Next never-used chunk in `slabs`.
+    char       *cursor_end;  // 1 past the last chunk that fits in `slabs`.
+    size_t      chunk_size;  // Rounded up to a multiple of `chunk_align`.
+    size_t      chunk_align;
+    size_t      live;        // Number of chunks currently handed out.
+    size_t      slab_count;
+    Allocator   backing;     // Where the slabs come from.
+} Pool;
+
+/**
+ * @brief
+ *      Initializes `pool` to hand out chunks of `chunk_size` bytes aligned to
+ *      `chunk_align`. No slab is allocated until the first allocation.
+ *
+ * @note
+ *      `chunk_align` may not exceed `alignof(max_align_t)`.
+ */
+void
+pool_init(Pool *pool, size_t chunk_size, size_t chunk_align, Allocator backing);
+
+#define pool_init_type(pool, T, backing)                                       \
+    pool_init(pool, sizeof(T), alignof(T), backing)
+
+/**
+ * @brief
+ *      Returns all of the slabs of `pool` to its backing allocator.
+ */
+void
+pool_destroy(Pool *pool);
+
+/**
+ * @return
+ *      A chunk of `pool->chunk_size` bytes, or `NULL` if a new slab was needed
+ *      but could not be allocated.
+ */
+void *
+pool_rawalloc(Pool *pool);
+
+/**
+ * @brief
+ *      The fast path of `pool_rawalloc` which the compiler can inline: pop the
+ *      free list, or take the next never-used chunk of the newest slab.
+ */
+static inline void *
+pool_rawalloc_inline(Pool *pool)
+{
+    Pool_Chunk *chunk = pool->free_list;
+    if (chunk != NULL) {
+        pool->free_list = chunk->next;
+        pool->live++;
+        return chunk;
+    }
+    if (pool->cursor != pool->cursor_end) {
+        void *data    = pool->cursor;
+        pool->cursor += pool->chunk_size;
+        pool->live++;
+        return data;
+    }
+    return pool_rawalloc(pool);
+}
+
+/**
+ * @brief
+ *      Allocate `count` chunks at once, writing them to `out_ptrs`. Freed
+ *      chunks are taken first, then the rest are carved out of the newest slab
+ *      in 1 go.
+ *
+ * @return
+ *      `false` if a new slab was needed but could not be allocated, in which
+ *      case none of the chunks are taken.
+ */
+bool
+pool_rawalloc_many(Pool *pool, void **out_ptrs, size_t count);
+
+/**
+ * @brief
+ *      Put `ptr`, which must have come from `pool`, back on the free list.
+ */
+void
+pool_rawfree(Pool *pool, void *ptr);
+
+/**
+ * @brief
+ *      Free every chunk at once. The newest slab is kept for reuse.
+ */
+void
+pool_free_all(Pool *pool);
+
+/**
+ * @brief
+ *      Get the number of bytes handed out, and optionally the total number of
+ *      bytes held in slabs, headers included.
+ */
+size_t
+pool_get_usage(const Pool *pool, size_t *out_total);
+
+/**
+ * @brief
+ *      Create a stack-allocated `Allocator` instance out of a `Pool *`.
+ *
+ * @note
+ *      Requests bigger than `chunk_size`, or more aligned than `chunk_align`,
+ *      fail with `Allocator_Error_Out_Of_Memory`. `mem_make` is thus only
+ *      usable with a count of 1.
+ */
+Allocator
+pool_allocator(Pool *pool);
+
+#ifdef DSA_POOL_IMPLEMENTATION
+
+#include <assert.h> // assert
+
+void
+pool_init(Pool *pool, size_t chunk_size, size_t chunk_align, Allocator backing)
+{
+    assert(chunk_align != 0 && (chunk_align & (chunk_align - 1)) == 0);
+    assert(chunk_align <= alignof(max_align_t));
+
+    // Every chunk must be able to hold a free list link when it is freed.
+    if (chunk_size < sizeof(Pool_Chunk))
+        chunk_size = sizeof(Pool_Chunk);
+    if (chunk_align < alignof(Pool_Chunk))
+        chunk_align = alignof(Pool_Chunk);
+    chunk_size = (chunk_size + chunk_align - 1) & ~(chunk_align - 1);
+
+    *pool = (Pool){
+        .slabs       = NULL,
+        .free_list   = NULL,
+        .cursor      = NULL,
+        .cursor_end  = NULL,
+        .chunk_size  = chunk_size,
+        .chunk_align = chunk_align,
+        .live        = 0,
+        .slab_count  = 0,
+        .backing     = backing,
+    };
+}
+
+static void
+_pool_slab_free_chain(Pool_Slab *slab, Allocator backing)
+{
+    while (slab != NULL) {
+        Pool_Slab *prev = slab->prev;
+        // Backing allocators that cannot free (e.g. arenas) simply ignore this.
+        mem_rawfree(slab, sizeof(*slab) + slab->size, backing);
+        slab = prev;
+    }
+}
+
+void
+pool_destroy(Pool *pool)
+{
+    _pool_slab_free_chain(pool->slabs, pool->backing);
+    pool->slabs      = NULL;
+    pool->free_list  = NULL;
+    pool->cursor     = NULL;
+    pool->cursor_end = NULL;
+    pool->live       = 0;
+    pool->slab_count = 0;
+}
+
+static void
+_pool_set_cursor(Pool *pool, Pool_Slab *slab)
+{
+    size_t count     = slab->size / pool->chunk_size;
+    pool->cursor     = slab->base;
+    pool->cursor_end = slab->base + count * pool->chunk_size;
+}
+
+/**
+ * @brief
+ *      Internal implementation function. Chain a new slab and point the cursor
+ *      at it.
+ */
+static bool
+_pool_add_slab(Pool *pool)
+{
+    size_t size = POOL_SLAB_SIZE;
+    if (size < sizeof(Pool_Slab) + pool->chunk_size)
+        size = sizeof(Pool_Slab) + pool->chunk_size;
+
+    Allocator_Error error;
+    Pool_Slab      *slab = cast(Pool_Slab *)mem_rawnew_loc(&error, size, alignof(Pool_Slab), pool->backing, SOURCE_LOCATION);
+    if (error)
+        return false;
+
+    slab->prev  = pool->slabs;
+    slab->size  = size - sizeof(*slab);
+    pool->slabs = slab;
+    pool->slab_count++;
+    _pool_set_cursor(pool, slab);
+    return true;
+}
+
+static void *
+_pool_rawalloc_slow(Pool *pool)
+{
+    if (!_pool_add_slab(pool))
+        return NULL;
+    return pool_rawalloc(pool);
+}
+
+void *
+pool_rawalloc(Pool *pool)
+{
+    Pool_Chunk *chunk = pool->free_list;
+    if (chunk != NULL) {
+        pool->free_list = chunk->next;
+        pool->live++;
+        return chunk;
+    }
+    if (pool->cursor != pool->cursor_end) {
+        void *data    = pool->cursor;
+        pool->cursor += pool->chunk_size;
+        pool->live++;
+        return data;
+    }
+    return _pool_rawalloc_slow(pool);
+}
+
+bool
+pool_rawalloc_many(Pool *pool, void **out_ptrs, size_t count)
+{
+    size_t i = 0;
+    for (; i < count && pool->free_list != NULL; ++i) {
+        out_ptrs[i]     = pool->free_list;
+        pool->free_list = pool->free_list->next;
+    }
+
+    while (i < count) {
+        size_t left = cast(size_t)(pool->cursor_end - pool->cursor) / pool->chunk_size;
+        if (left == 0 && !_pool_add_slab(pool)) {
+            // None of these were counted as live yet, so just chain them back.
+            while (i > 0) {
+                Pool_Chunk *chunk = cast(Pool_Chunk *)out_ptrs[--i];
+                chunk->next     = pool->free_list;
+                pool->free_list = chunk;
+            }
+            return false;
+        }
+        for (; left > 0 && i < count; --left, ++i) {
+            out_ptrs[i]   = pool->cursor;
+            pool->cursor += pool->chunk_size;
+        }
+    }
+    pool->live += count;
+    return true;
+}
+
+void
+pool_rawfree(Pool *pool, void *ptr)
+{
+    if (ptr == NULL)
+        return;
+    Pool_Chunk *chunk = cast(Pool_Chunk *)ptr;
+    chunk->next     = pool->free_list;
+    pool->free_list = chunk;
+    pool->live--;
+}
+
+void
+pool_free_all(Pool *pool)
+{
+    Pool_Slab *slab = pool->slabs;
+    if (slab == NULL)
+        return;
+    _pool_slab_free_chain(slab->prev, pool->backing);
+    slab->prev       = NULL;
+    pool->free_list  = NULL;
+    pool->live       = 0;
+    pool->slab_count = 1;
+    _pool_set_cursor(pool, slab);
+}
+
+size_t
+pool_get_usage(const Pool *pool, size_t *out_total)
+{
+    if (out_total != NULL) {
+        size_t total = 0;
+        for (const Pool_Slab *slab = pool->slabs; slab != NULL; slab = slab->prev)
+            total += sizeof(*slab) + slab->size;
+        *out_total = total;
+    }
+    return pool->live * pool->chunk_size;
+}
+
+static void *
+_pool_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Pool *pool = cast(Pool *)user_ptr;
+    void *data = NULL;
+    *out_error = Allocator_Error_None;
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+        if (args.new_size > pool->chunk_size || args.alignment > pool->chunk_align) {
+            *out_error = Allocator_Error_Out_Of_Memory;
+            break;
+        }
+        data = pool_rawalloc(pool);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        else if (args.out_size != NULL)
+            *args.out_size = pool->chunk_size;
+        break;
+
+    case Allocator_Mode_Resize:
+        // Every chunk is already as big as it can get.
+        if (args.new_size > pool->chunk_size || args.alignment > pool->chunk_align) {
+            *out_error = Allocator_Error_Out_Of_Memory;
+            break;
+        }
+        data = (args.old_ptr != NULL) ? args.old_ptr : pool_rawalloc(pool);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        else if (args.out_size != NULL)
+            *args.out_size = pool->chunk_size;
+        break;
+
+    case Allocator_Mode_Alloc_Many:
+        if (args.new_size > pool->chunk_size || args.alignment > pool->chunk_align)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        else if (!pool_rawalloc_many(pool, args.out_ptrs, args.count))
+            *out_error = Allocator_Error_Out_Of_Memory;
+        break;
+
+    // Chunks are too small for zeroing to be anything but a `memset`, which
+    // the caller does just as well.
+    case Allocator_Mode_Alloc_Zeroed:
+        *out_error = Allocator_Error_Mode_Not_Implemented;
+        break;
+
+    case Allocator_Mode_Free:
+        pool_rawfree(pool, args.old_ptr);
+        break;
+
+    case Allocator_Mode_Free_All:
+        pool_free_all(pool);
+        break;
+
+    default:
+        assert(false);
+    }
+    return data;
+}
+
+Allocator
+pool_allocator(Pool *pool)
+{
+    Allocator allocator = {.fn = &_pool_allocator_fn, .user_ptr = pool};
+    return allocator;
+}
+
+#endif // DSA_POOL_IMPLEMENTATION
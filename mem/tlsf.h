@@ -0,0 +1,579 @@
+#pragma once
+
+#ifdef DSA_IMPLEMENTATION
+#define DSA_TLSF_IMPLEMENTATION
+#endif // DSA_IMPLEMENTATION
+
+#include "../common.h"
+#include "allocator.h"
+
+/**
+ * @brief
+ *      Two-Level Segregated Fit: a general purpose allocator whose allocation,
+ *      resize and free all run in bounded time, no matter how fragmented the
+ *      memory it manages gets.
+ *
+ * @link
+ *      http://www.gii.upv.es/tlsf/
+ */
+
+// Every block is aligned to, and every size is a multiple of, this.
+#define TLSF_ALIGN_LOG2 4
+#define TLSF_ALIGN      (1 << TLSF_ALIGN_LOG2)
+
+// Each power of 2 size range is split into this many second-level lists.
+#define TLSF_SL_LOG2    5
+#define TLSF_SL_COUNT   (1 << TLSF_SL_LOG2)
+
+// Sizes below `TLSF_SMALL_SIZE` all go in first-level list 0, spaced
+// `TLSF_ALIGN` apart. Each first-level list above that covers 1 power of 2.
+#define TLSF_FL_SHIFT   (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_SMALL_SIZE (1 << TLSF_FL_SHIFT)
+
+#ifndef TLSF_FL_MAX
+// Blocks are less than `2^TLSF_FL_MAX` bytes.
+#define TLSF_FL_MAX     40
+#endif // TLSF_FL_MAX
+
+#define TLSF_FL_COUNT   (TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_MAX_SIZE   ((size_t)1 << (TLSF_FL_MAX - 1))
+
+_Static_assert(TLSF_FL_COUNT <= 32, "fl_bitmap cannot hold TLSF_FL_COUNT bits");
+
+typedef struct Tlsf_Block Tlsf_Block;
+struct Tlsf_Block {
+    Tlsf_Block *prev_phys; // Block right before us in memory, or `NULL`.
+    size_t      size;      // Bytes of payload. The lowest bit is set if free.
+
+    // Only valid while free. Otherwise, these are the start of the payload.
+    Tlsf_Block *next_free;
+    Tlsf_Block *prev_free;
+};
+
+/**
+ * @note
+ *      `blocks[fl][sl]` heads the free list for that size class. A set bit
+ *      in `fl_bitmap`, and then in `sl_bitmap[fl]`, means that list is not
+ *      empty, so finding a fit is just 2 find-first-set operations.
+ *
+ *      Every region ends in a zero-sized block that is never free, so the
+ *      last real block always has a `next` to look at when coalescing.
+ */
+typedef struct {
+    uint32_t    fl_bitmap;
+    uint32_t    sl_bitmap[TLSF_FL_COUNT];
+    Tlsf_Block *blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+    size_t      used;         // Bytes of payload currently allocated.
+    void       *mapping;      // Pool from `tlsf_init_mmap()`, if any.
+    size_t      mapping_size;
+} Tlsf;
+
+/**
+ * @brief
+ *      Initializes `tlsf` to manage the `size` bytes at `memory`, which the
+ *      caller owns and must keep alive for as long as `tlsf` is used.
+ *
+ * @return
+ *      `Allocator_Error_Out_Of_Memory` if the region is too small to hold
+ *      even 1 block.
+ */
+Allocator_Error
+tlsf_init(Tlsf *tlsf, void *memory, size_t size);
+
+/**
+ * @brief
+ *      Initializes `tlsf` with a pool of `size` bytes of its own, mapped with
+ *      `mmap` and prefaulted where possible so that first use never hits
+ *      a page fault. `tlsf_destroy()` unmaps it.
+ *
+ * @return
+ *      `Allocator_Error_Mode_Not_Implemented` on platforms without `mmap`.
+ */
+Allocator_Error
+tlsf_init_mmap(Tlsf *tlsf, size_t size);
+
+/**
+ * @brief
+ *      Give `tlsf` another caller-owned region to allocate from.
+ *
+ * @note
+ *      Regions larger than `TLSF_MAX_SIZE` are cut short.
+ */
+Allocator_Error
+tlsf_add_region(Tlsf *tlsf, void *memory, size_t size);
+
+/**
+ * @brief
+ *      Unmaps the pool from `tlsf_init_mmap()`, if any. Caller-provided
+ *      regions are left alone.
+ */
+void
+tlsf_destroy(Tlsf *tlsf);
+
+/**
+ * @brief
+ *      Allocate `size` bytes aligned to `align`, which must be a power of 2.
+ *      Alignments up to `TLSF_ALIGN` cost nothing extra.
+ *
+ * @return
+ *      `NULL` if no free block is big enough.
+ */
+void *
+tlsf_rawalloc(Tlsf *tlsf, size_t size, size_t align);
+
+/**
+ * @brief
+ *      Shrink or grow `ptr` in place if possible, otherwise allocate, copy and
+ *      free. On failure `ptr` is left untouched.
+ */
+void *
+tlsf_rawresize(Tlsf *tlsf, void *ptr, size_t old_size, size_t new_size, size_t align);
+
+void
+tlsf_rawfree(Tlsf *tlsf, void *ptr);
+
+/**
+ * @brief
+ *      Create a stack-allocated `Allocator` instance out of a `Tlsf *`.
+ *
+ * @note
+ *      `Allocator_Mode_Free_All` is not implemented.
+ */
+Allocator
+tlsf_allocator(Tlsf *tlsf);
+
+#ifdef DSA_TLSF_IMPLEMENTATION
+
+#include <assert.h> // assert
+#include <string.h> // memcpy, memset
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TLSF_HAS_MMAP
+#include <sys/mman.h> // mmap, munmap
+#endif
+
+#define TLSF_FREE_BIT   cast(size_t)1
+#define TLSF_HEADER     offsetof(Tlsf_Block, next_free)
+#define TLSF_MIN_SIZE   (sizeof(Tlsf_Block) - TLSF_HEADER)
+
+_Static_assert(TLSF_HEADER % TLSF_ALIGN == 0, "payloads would be misaligned");
+
+//=== BLOCKS =============================================================== {{{
+
+static inline size_t
+_tlsf_block_size(const Tlsf_Block *block)
+{
+    return block->size & ~TLSF_FREE_BIT;
+}
+
+static inline bool
+_tlsf_block_is_free(const Tlsf_Block *block)
+{
+    return (block->size & TLSF_FREE_BIT) != 0;
+}
+
+static inline char *
+_tlsf_block_ptr(Tlsf_Block *block)
+{
+    return cast(char *)block + TLSF_HEADER;
+}
+
+static inline Tlsf_Block *
+_tlsf_block_from_ptr(void *ptr)
+{
+    return cast(Tlsf_Block *)(cast(char *)ptr - TLSF_HEADER);
+}
+
+static inline Tlsf_Block *
+_tlsf_block_next(Tlsf_Block *block)
+{
+    return cast(Tlsf_Block *)(_tlsf_block_ptr(block) + _tlsf_block_size(block));
+}
+
+/**
+ * @return
+ *      `size` rounded up to a valid block size, or 0 if it is too large.
+ */
+static inline size_t
+_tlsf_adjust_size(size_t size)
+{
+    if (size > TLSF_MAX_SIZE)
+        return 0;
+    size = (size + (TLSF_ALIGN - 1)) & ~cast(size_t)(TLSF_ALIGN - 1);
+    return (size < TLSF_MIN_SIZE) ? TLSF_MIN_SIZE : size;
+}
+
+//=== }}} ======================================================================
+
+//=== SIZE CLASSES ========================================================= {{{
+
+static inline int
+_tlsf_fls(size_t x)
+{
+    return 63 - __builtin_clzll(cast(unsigned long long)x);
+}
+
+static inline int
+_tlsf_ffs(uint32_t x)
+{
+    return __builtin_ctz(x);
+}
+
+static inline void
+_tlsf_mapping_insert(size_t size, int *out_fl, int *out_sl)
+{
+    if (size < TLSF_SMALL_SIZE) {
+        *out_fl = 0;
+        *out_sl = cast(int)(size / (TLSF_SMALL_SIZE / TLSF_SL_COUNT));
+    } else {
+        int fl  = _tlsf_fls(size);
+        *out_sl = cast(int)(size >> (fl - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+        *out_fl = fl - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+/**
+ * @brief
+ *      Like `_tlsf_mapping_insert()`, but rounds `size` up to the next size
+ *      class so that any block in the resulting list is big enough.
+ */
+static inline void
+_tlsf_mapping_search(size_t size, int *out_fl, int *out_sl)
+{
+    if (size >= TLSF_SMALL_SIZE)
+        size += (cast(size_t)1 << (_tlsf_fls(size) - TLSF_SL_LOG2)) - 1;
+    _tlsf_mapping_insert(size, out_fl, out_sl);
+}
+
+static void
+_tlsf_remove_free(Tlsf *tlsf, Tlsf_Block *block)
+{
+    int fl, sl;
+    _tlsf_mapping_insert(_tlsf_block_size(block), &fl, &sl);
+
+    Tlsf_Block *next = block->next_free;
+    Tlsf_Block *prev = block->prev_free;
+    if (next != NULL)
+        next->prev_free = prev;
+    if (prev != NULL) {
+        prev->next_free = next;
+        return;
+    }
+
+    // `block` was the head of its list.
+    tlsf->blocks[fl][sl] = next;
+    if (next == NULL) {
+        tlsf->sl_bitmap[fl] &= ~(1U << sl);
+        if (tlsf->sl_bitmap[fl] == 0)
+            tlsf->fl_bitmap &= ~(1U << fl);
+    }
+}
+
+static void
+_tlsf_insert_free(Tlsf *tlsf, Tlsf_Block *block)
+{
+    int fl, sl;
+    _tlsf_mapping_insert(_tlsf_block_size(block), &fl, &sl);
+
+    Tlsf_Block *head = tlsf->blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL)
+        head->prev_free = block;
+    tlsf->blocks[fl][sl]  = block;
+    tlsf->sl_bitmap[fl]  |= 1U << sl;
+    tlsf->fl_bitmap      |= 1U << fl;
+}
+
+/**
+ * @brief
+ *      Take the head of the first non-empty list whose blocks all hold at
+ *      least `size` bytes out of its list.
+ */
+static Tlsf_Block *
+_tlsf_locate_free(Tlsf *tlsf, size_t size)
+{
+    int fl, sl;
+    _tlsf_mapping_search(size, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT)
+        return NULL;
+
+    uint32_t sl_map = tlsf->sl_bitmap[fl] & (~0U << sl);
+    if (sl_map == 0) {
+        // Nothing in this power of 2; try the next one up that has anything.
+        uint32_t fl_map = (fl + 1 < 32) ? tlsf->fl_bitmap & (~0U << (fl + 1)) : 0;
+        if (fl_map == 0)
+            return NULL;
+        fl     = _tlsf_ffs(fl_map);
+        sl_map = tlsf->sl_bitmap[fl];
+    }
+    sl = _tlsf_ffs(sl_map);
+
+    Tlsf_Block *block = tlsf->blocks[fl][sl];
+    _tlsf_remove_free(tlsf, block);
+    return block;
+}
+
+//=== }}} ======================================================================
+
+/**
+ * @brief
+ *      Mark `block` as free, merge it with its free neighbors, if any, then put
+ *      the result in its free list. Free blocks are thus never adjacent.
+ */
+static void
+_tlsf_release(Tlsf *tlsf, Tlsf_Block *block)
+{
+    Tlsf_Block *next = _tlsf_block_next(block);
+    if (_tlsf_block_is_free(next)) {
+        _tlsf_remove_free(tlsf, next);
+        block->size = _tlsf_block_size(block) + TLSF_HEADER + _tlsf_block_size(next);
+    }
+
+    Tlsf_Block *prev = block->prev_phys;
+    if (prev != NULL && _tlsf_block_is_free(prev)) {
+        _tlsf_remove_free(tlsf, prev);
+        prev->size = _tlsf_block_size(prev) + TLSF_HEADER + _tlsf_block_size(block);
+        block      = prev;
+    }
+
+    block->size |= TLSF_FREE_BIT;
+    _tlsf_block_next(block)->prev_phys = block;
+    _tlsf_insert_free(tlsf, block);
+}
+
+/**
+ * @brief
+ *      Shrink the allocated `block` to `size` bytes, giving back the rest if
+ *      it is big enough to be a block of its own.
+ */
+static void
+_tlsf_trim(Tlsf *tlsf, Tlsf_Block *block, size_t size)
+{
+    size_t total = _tlsf_block_size(block);
+    if (total < size + TLSF_HEADER + TLSF_MIN_SIZE)
+        return;
+
+    Tlsf_Block *rest = cast(Tlsf_Block *)(_tlsf_block_ptr(block) + size);
+    rest->prev_phys = block;
+    rest->size      = total - size - TLSF_HEADER;
+    block->size     = size;
+    _tlsf_release(tlsf, rest);
+}
+
+static void
+_tlsf_reset(Tlsf *tlsf)
+{
+    memset(tlsf, 0, sizeof(*tlsf));
+}
+
+Allocator_Error
+tlsf_add_region(Tlsf *tlsf, void *memory, size_t size)
+{
+    const uintptr_t mask  = ~cast(uintptr_t)(TLSF_ALIGN - 1);
+    uintptr_t       start = (cast(uintptr_t)memory + (TLSF_ALIGN - 1)) & mask;
+    uintptr_t       end   = (cast(uintptr_t)memory + size) & mask;
+    if (end <= start || end - start < 2 * TLSF_HEADER + TLSF_MIN_SIZE)
+        return Allocator_Error_Out_Of_Memory;
+
+    // Leave room for the header of the sentinel at the very end.
+    size_t payload = cast(size_t)(end - start) - 2 * TLSF_HEADER;
+    if (payload > TLSF_MAX_SIZE)
+        payload = TLSF_MAX_SIZE;
+
+    Tlsf_Block *block = cast(Tlsf_Block *)start;
+    block->prev_phys  = NULL;
+    block->size       = payload;
+
+    Tlsf_Block *sentinel = _tlsf_block_next(block);
+    sentinel->prev_phys  = block;
+    sentinel->size       = 0;
+
+    block->size |= TLSF_FREE_BIT;
+    _tlsf_insert_free(tlsf, block);
+    return Allocator_Error_None;
+}
+
+Allocator_Error
+tlsf_init(Tlsf *tlsf, void *memory, size_t size)
+{
+    _tlsf_reset(tlsf);
+    return tlsf_add_region(tlsf, memory, size);
+}
+
+Allocator_Error
+tlsf_init_mmap(Tlsf *tlsf, size_t size)
+{
+    _tlsf_reset(tlsf);
+#ifdef TLSF_HAS_MMAP
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif // MAP_POPULATE
+
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (memory == MAP_FAILED)
+        return Allocator_Error_Out_Of_Memory;
+    tlsf->mapping      = memory;
+    tlsf->mapping_size = size;
+
+    Allocator_Error error = tlsf_add_region(tlsf, memory, size);
+    if (error)
+        tlsf_destroy(tlsf);
+    return error;
+#else // !TLSF_HAS_MMAP
+    unused(size);
+    return Allocator_Error_Mode_Not_Implemented;
+#endif // TLSF_HAS_MMAP
+}
+
+void
+tlsf_destroy(Tlsf *tlsf)
+{
+#ifdef TLSF_HAS_MMAP
+    if (tlsf->mapping != NULL)
+        munmap(tlsf->mapping, tlsf->mapping_size);
+#endif // TLSF_HAS_MMAP
+    _tlsf_reset(tlsf);
+}
+
+void *
+tlsf_rawalloc(Tlsf *tlsf, size_t size, size_t align)
+{
+    assert(align != 0 && (align & (align - 1)) == 0);
+    size_t adjust = _tlsf_adjust_size(size);
+    if (adjust == 0 || align > TLSF_MAX_SIZE)
+        return NULL;
+
+    // Over-aligned requests need room to slide forward. The gap we leave
+    // behind must be able to stand on its own as a free block.
+    const size_t gap_min = TLSF_HEADER + TLSF_MIN_SIZE;
+    size_t       search  = (align <= TLSF_ALIGN) ? adjust : adjust + align + gap_min;
+    Tlsf_Block  *block   = _tlsf_locate_free(tlsf, search);
+    if (block == NULL)
+        return NULL;
+
+    if (align > TLSF_ALIGN) {
+        uintptr_t ptr     = cast(uintptr_t)_tlsf_block_ptr(block);
+        uintptr_t aligned = (ptr + (align - 1)) & ~cast(uintptr_t)(align - 1);
+        if (aligned != ptr && aligned - ptr < gap_min)
+            aligned = (ptr + gap_min + (align - 1)) & ~cast(uintptr_t)(align - 1);
+
+        size_t gap = cast(size_t)(aligned - ptr);
+        if (gap != 0) {
+            Tlsf_Block *next = cast(Tlsf_Block *)(aligned - TLSF_HEADER);
+            next->prev_phys  = block;
+            next->size       = _tlsf_block_size(block) - gap;
+            _tlsf_block_next(next)->prev_phys = next;
+
+            // The previous block cannot be free, so no merging to do.
+            block->size = (gap - TLSF_HEADER) | TLSF_FREE_BIT;
+            _tlsf_insert_free(tlsf, block);
+            block = next;
+        }
+    }
+
+    block->size = _tlsf_block_size(block);
+    _tlsf_trim(tlsf, block, adjust);
+    tlsf->used += _tlsf_block_size(block);
+    return _tlsf_block_ptr(block);
+}
+
+void *
+tlsf_rawresize(Tlsf *tlsf, void *ptr, size_t old_size, size_t new_size, size_t align)
+{
+    if (ptr == NULL)
+        return tlsf_rawalloc(tlsf, new_size, align);
+
+    Tlsf_Block *block  = _tlsf_block_from_ptr(ptr);
+    size_t      size   = _tlsf_block_size(block);
+    size_t      adjust = _tlsf_adjust_size(new_size);
+    if (adjust == 0)
+        return NULL;
+
+    if (adjust > size) {
+        // Grow in place by absorbing the next block, if it is free and enough.
+        Tlsf_Block *next = _tlsf_block_next(block);
+        if (!_tlsf_block_is_free(next) || size + TLSF_HEADER + _tlsf_block_size(next) < adjust) {
+            void *data = tlsf_rawalloc(tlsf, new_size, align);
+            if (data != NULL) {
+                memcpy(data, ptr, (old_size < size) ? old_size : size);
+                tlsf_rawfree(tlsf, ptr);
+            }
+            return data;
+        }
+        _tlsf_remove_free(tlsf, next);
+        block->size = size + TLSF_HEADER + _tlsf_block_size(next);
+        _tlsf_block_next(block)->prev_phys = block;
+    }
+
+    tlsf->used -= size;
+    _tlsf_trim(tlsf, block, adjust);
+    tlsf->used += _tlsf_block_size(block);
+    return ptr;
+}
+
+void
+tlsf_rawfree(Tlsf *tlsf, void *ptr)
+{
+    if (ptr == NULL)
+        return;
+    Tlsf_Block *block = _tlsf_block_from_ptr(ptr);
+    assert(!_tlsf_block_is_free(block));
+    tlsf->used -= _tlsf_block_size(block);
+    _tlsf_release(tlsf, block);
+}
+
+static void *
+_tlsf_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Tlsf *tlsf = cast(Tlsf *)user_ptr;
+    void *data = NULL;
+    *out_error = Allocator_Error_None;
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+        data = tlsf_rawalloc(tlsf, args.new_size, args.alignment);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        else if (args.out_size != NULL)
+            *args.out_size = _tlsf_block_size(_tlsf_block_from_ptr(data));
+        break;
+
+    case Allocator_Mode_Resize:
+        data = tlsf_rawresize(tlsf, args.old_ptr, args.old_size, args.new_size, args.alignment);
+        if (data == NULL)
+            *out_error = Allocator_Error_Out_Of_Memory;
+        else if (args.out_size != NULL)
+            *args.out_size = _tlsf_block_size(_tlsf_block_from_ptr(data));
+        break;
+
+    case Allocator_Mode_Free:
+        tlsf_rawfree(tlsf, args.old_ptr);
+        break;
+
+    // Blocks are reused as soon as they are freed, so they are never known
+    // to be zero. Batches would each need their own search anyway.
+    case Allocator_Mode_Alloc_Zeroed:
+    case Allocator_Mode_Alloc_Many:
+    case Allocator_Mode_Free_All:
+        *out_error = Allocator_Error_Mode_Not_Implemented;
+        break;
+
+    default:
+        assert(false);
+    }
+    return data;
+}
+
+Allocator
+tlsf_allocator(Tlsf *tlsf)
+{
+    Allocator allocator = {.fn = &_tlsf_allocator_fn, .user_ptr = tlsf};
+    return allocator;
+}
+
+#undef TLSF_FREE_BIT
+#undef TLSF_HEADER
+#undef TLSF_MIN_SIZE
+
+#endif // DSA_TLSF_IMPLEMENTATION
@@ -0,0 +1,254 @@
+#pragma once
+
+#ifdef DSA_IMPLEMENTATION
+#define DSA_TRACKING_IMPLEMENTATION
+#endif // DSA_IMPLEMENTATION
+
+#include "../common.h"
+#include "allocator.h"
+
+#ifndef TRACKING_SIZE_CLASS_COUNT
+// Class 0 holds requests of up to 16 bytes, then each class doubles. The last
+// one holds everything bigger.
+#define TRACKING_SIZE_CLASS_COUNT   16
+#endif // TRACKING_SIZE_CLASS_COUNT
+
+#ifndef TRACKING_CALLSITE_MAX
+// How many distinct callsites we can tell apart. Must be a power of 2.
+#define TRACKING_CALLSITE_MAX       256
+#endif // TRACKING_CALLSITE_MAX
+
+typedef struct {
+    Source_Location location; // `file` is `NULL` for unused slots.
+    size_t          count;    // Allocations and resizes made from here.
+    size_t          bytes;    // Bytes requested from here, in total.
+} Tracking_Callsite;
+
+/**
+ * @brief
+ *      Wraps any `Allocator` and keeps statistics on everything that goes
+ *      through it. Every request costs a handful of counter updates, plus
+ *      1 hash table probe when `track_callsites` is set.
+ *
+ * @note
+ *      Callsites come from the `Source_Location` that the `mem_*` macros pass
+ *      along. Since nothing is stored per allocation, callsites only know what
+ *      they allocated, not what is still live.
+ *
+ *      Like `Arena`, this is not thread-safe.
+ */
+typedef struct {
+    Allocator         inner;
+    size_t            alloc_count;
+    size_t            free_count;
+    size_t            resize_in_place; // Resizes that kept their pointer.
+    size_t            resize_copy;     // Resizes that moved.
+    size_t            failures;
+    size_t            live_bytes;
+    size_t            peak_bytes;
+    size_t            total_bytes;     // Everything ever requested.
+    size_t            size_classes[TRACKING_SIZE_CLASS_COUNT];
+    bool              track_callsites;
+    size_t            callsite_count;
+    size_t            callsites_dropped; // Requests from callsites that did not fit.
+    Tracking_Callsite callsites[TRACKING_CALLSITE_MAX];
+} Tracking_Allocator;
+
+void
+tracking_allocator_init(Tracking_Allocator *tracker, Allocator inner, bool track_callsites);
+
+/**
+ * @brief
+ *      Create a stack-allocated `Allocator` instance which forwards everything
+ *      to `tracker->inner`, recording what happens along the way.
+ */
+Allocator
+tracking_allocator(Tracking_Allocator *tracker);
+
+/**
+ * @brief
+ *      Write a human-readable summary of `tracker` to `stream`. Callsites are
+ *      listed from most to fewest bytes requested.
+ */
+void
+tracking_allocator_report(const Tracking_Allocator *tracker, FILE *stream);
+
+#ifdef DSA_TRACKING_IMPLEMENTATION
+
+#include <assert.h> // assert
+#include <string.h> // memset
+
+_Static_assert((TRACKING_CALLSITE_MAX & (TRACKING_CALLSITE_MAX - 1)) == 0,
+    "TRACKING_CALLSITE_MAX must be a power of 2");
+
+void
+tracking_allocator_init(Tracking_Allocator *tracker, Allocator inner, bool track_callsites)
+{
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->inner           = inner;
+    tracker->track_callsites = track_callsites;
+}
+
+static size_t
+_tracking_size_class(size_t size)
+{
+    size_t index = 0;
+    for (size_t limit = 16; size > limit && index < TRACKING_SIZE_CLASS_COUNT - 1; limit <<= 1)
+        ++index;
+    return index;
+}
+
+static void
+_tracking_callsite_record(Tracking_Allocator *tracker, Source_Location location, size_t size)
+{
+    if (location.file == NULL)
+        return;
+
+    // Compare `file` by pointer. At worst, a header used by several
+    // translation units shows up once per unit.
+    const size_t mask = TRACKING_CALLSITE_MAX - 1;
+    uintptr_t    hash = cast(uintptr_t)location.file ^ (cast(uintptr_t)cast(unsigned)location.line * cast(uintptr_t)0x9e3779b97f4a7c15ULL);
+    for (size_t i = cast(size_t)(hash >> 7) & mask, probe = 0; probe < TRACKING_CALLSITE_MAX; i = (i + 1) & mask, ++probe) {
+        Tracking_Callsite *callsite = &tracker->callsites[i];
+        if (callsite->location.file == NULL) {
+            // Keep the table at most 3/4 full so misses stay short.
+            if (4 * (tracker->callsite_count + 1) > 3 * TRACKING_CALLSITE_MAX)
+                break;
+            callsite->location = location;
+            tracker->callsite_count++;
+        } else if (callsite->location.file != location.file || callsite->location.line != location.line) {
+            continue;
+        }
+        callsite->count++;
+        callsite->bytes += size;
+        return;
+    }
+    tracker->callsites_dropped++;
+}
+
+static void
+_tracking_add_live(Tracking_Allocator *tracker, size_t size)
+{
+    tracker->live_bytes  += size;
+    tracker->total_bytes += size;
+    if (tracker->live_bytes > tracker->peak_bytes)
+        tracker->peak_bytes = tracker->live_bytes;
+}
+
+static void *
+_tracking_allocator_fn(Allocator_Error *out_error, void *user_ptr, Allocator_Mode mode, Allocator_Args args)
+{
+    Tracking_Allocator *tracker = cast(Tracking_Allocator *)user_ptr;
+    Allocator           inner   = tracker->inner;
+    void               *data    = inner.fn(out_error, inner.user_ptr, mode, args);
+    if (*out_error) {
+        if (*out_error != Allocator_Error_Mode_Not_Implemented)
+            tracker->failures++;
+        return data;
+    }
+
+    // The caller owns, and will later free, the whole usable size.
+    size_t new_size = (args.out_size != NULL) ? *args.out_size : args.new_size;
+    switch (mode) {
+    case Allocator_Mode_Alloc:
+    case Allocator_Mode_Alloc_Zeroed:
+        tracker->alloc_count++;
+        tracker->size_classes[_tracking_size_class(args.new_size)]++;
+        _tracking_add_live(tracker, new_size);
+        break;
+
+    case Allocator_Mode_Resize:
+        if (args.old_ptr == NULL)
+            tracker->alloc_count++;
+        else if (data == args.old_ptr)
+            tracker->resize_in_place++;
+        else
+            tracker->resize_copy++;
+        tracker->size_classes[_tracking_size_class(args.new_size)]++;
+        tracker->live_bytes -= args.old_size;
+        _tracking_add_live(tracker, new_size);
+        break;
+
+    case Allocator_Mode_Alloc_Many:
+        tracker->alloc_count += args.count;
+        tracker->size_classes[_tracking_size_class(args.new_size)] += args.count;
+        _tracking_add_live(tracker, args.new_size * args.count);
+        break;
+
+    case Allocator_Mode_Free:
+        if (args.old_ptr != NULL) {
+            tracker->free_count++;
+            tracker->live_bytes -= args.old_size;
+        }
+        return data;
+
+    case Allocator_Mode_Free_All:
+        tracker->live_bytes = 0;
+        return data;
+
+    default:
+        assert(false);
+    }
+
+    if (tracker->track_callsites)
+        _tracking_callsite_record(tracker, args.location, args.new_size);
+    return data;
+}
+
+Allocator
+tracking_allocator(Tracking_Allocator *tracker)
+{
+    Allocator allocator = {.fn = &_tracking_allocator_fn, .user_ptr = tracker};
+    return allocator;
+}
+
+void
+tracking_allocator_report(const Tracking_Allocator *tracker, FILE *stream)
+{
+    fprintfln(stream, "Allocations: %zu, frees: %zu, resizes: %zu in place, %zu with copy, failures: %zu",
+        tracker->alloc_count, tracker->free_count,
+        tracker->resize_in_place, tracker->resize_copy, tracker->failures);
+    fprintfln(stream, "Bytes: %zu live, %zu peak, %zu requested in total",
+        tracker->live_bytes, tracker->peak_bytes, tracker->total_bytes);
+
+    fprintln(stream, "Size classes:");
+    for (size_t i = 0; i < TRACKING_SIZE_CLASS_COUNT; ++i) {
+        size_t count = tracker->size_classes[i];
+        if (count == 0)
+            continue;
+        if (i == TRACKING_SIZE_CLASS_COUNT - 1)
+            fprintfln(stream, "    > %10zu: %zu", cast(size_t)16 << (i - 1), count);
+        else
+            fprintfln(stream, "    <= %9zu: %zu", cast(size_t)16 << i, count);
+    }
+
+    if (!tracker->track_callsites)
+        return;
+
+    // Selection sort of the indexes; there are only so many callsites.
+    size_t order[TRACKING_CALLSITE_MAX];
+    size_t len = 0;
+    for (size_t i = 0; i < TRACKING_CALLSITE_MAX; ++i) {
+        if (tracker->callsites[i].location.file != NULL)
+            order[len++] = i;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        size_t best = i;
+        for (size_t j = i + 1; j < len; ++j) {
+            if (tracker->callsites[order[j]].bytes > tracker->callsites[order[best]].bytes)
+                best = j;
+        }
+        size_t tmp  = order[i];
+        order[i]    = order[best];
+        order[best] = tmp;
+    }
+
+    fprintfln(stream, "Callsites: %zu (%zu requests dropped)", len, tracker->callsites_dropped);
+    for (size_t i = 0; i < len; ++i) {
+        const Tracking_Callsite *callsite = &tracker->callsites[order[i]];
+        fprintfln(stream, "    %s:%i: %zu requests, %zu bytes",
+            callsite->location.file, callsite->location.line, callsite->count, callsite->bytes);
+    }
+}
+
+#endif // DSA_TRACKING_IMPLEMENTATION
@@ -17,13 +17,15 @@ string_builder_make(Allocator allocator)
 String_Builder
 string_builder_make_fixed(char *buffer, size_t cap)
 {
-    // The memset is very important to ensure nul-termination.
     String_Builder builder = {
         .allocator = global_none_allocator,
-        .buffer    = cast(char *)memset(buffer, 0, cap),
+        .buffer    = buffer,
         .len       = 0,
         .cap       = cap,
     };
+    // Only `buffer[len]` needs to be nul; the rest is written before it is read.
+    if (cap > 0)
+        buffer[0] = '\0';
     return builder;
 }
 
@@ -43,7 +45,8 @@ void
 string_builder_reset(String_Builder *builder)
 {
     // This is necessary to ensure future writes are nul-terminated.
-    memset(&builder->buffer[0], 0, builder->cap);
+    if (builder->cap > 0)
+        builder->buffer[0] = '\0';
     builder->len = 0;
 }
 
@@ -70,8 +73,9 @@ _string_builder_check_resize(String_Builder *builder, size_t extra)
         }
         new_cap = tmp;
 
+        // The allocator may give us more than we asked for; take all of it.
         Allocator_Error error;
-        char           *new_buffer = mem_resize(char, &error, builder->buffer, cap, new_cap, builder->allocator);
+        char           *new_buffer = mem_resize_sized(char, &error, builder->buffer, cap, new_cap, builder->allocator, &new_cap);
         if (error)
             return error;
 
@@ -79,10 +83,10 @@ _string_builder_check_resize(String_Builder *builder, size_t extra)
         // over the old data to the new buffer.
         builder->buffer = new_buffer;
 
-        // Zero out the newly acquired region. Also helps with nul-termination.
-        // NOTE: memset with length 0 is defined as long as the pointer is valid.
-        memset(&new_buffer[len], 0, new_cap - len);
-        builder->cap = new_cap;
+        // Appends terminate what they write, so the new region is left as is.
+        // We only need to cover a buffer which was just allocated.
+        new_buffer[len] = '\0';
+        builder->cap    = new_cap;
     }
     return Allocator_Error_None;
 }
@@ -100,6 +104,7 @@ string_append_string(String_Builder *builder, String text)
 
     memcpy(&builder->buffer[builder->len], text.data, text.len);
     builder->len += text.len;
+    builder->buffer[builder->len] = '\0';
     return Allocator_Error_None;
 }
 
@@ -125,8 +130,7 @@ string_prepend_string(String_Builder *builder, String text)
 
     // Move the old text to the new location.
     // e.g. given "hi mom!" (len = 7), prepend "yay " (len = 4)
-    // 1.   Resize builder to be "hi mom!\0\0\0\0" (len = 11)
-    //      Note that the new region is zeroed out.
+    // 1.   Resize builder to be "hi mom!\0????" (len = 11)
     Allocator_Error err = _string_builder_check_resize(builder, text.len);
     if (err)
         return err;
@@ -138,6 +142,7 @@ string_prepend_string(String_Builder *builder, String text)
     // 3.   Copy new text to old location (0): "yay hi mom!"
     memcpy(&builder->buffer[0], text.data, text.len);
     builder->len += text.len;
+    builder->buffer[builder->len] = '\0';
     return Allocator_Error_None;
 }
 
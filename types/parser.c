@@ -327,6 +327,9 @@ _cparser_check_semantics(CParser *parser)
 
     // For non-basic types, fill in their missing data.
     switch (type->kind) {
+    // Basic types are complete as-is.
+    case CType_Kind_Basic:
+        break;
     // Pointers should already have their pointees set in `_cparser_set_pointer()`.
     case CType_Kind_Pointer:
         type->pointer.qualifiers = data->qualifiers;
@@ -343,20 +346,24 @@ static void
 _cparser_set_pointer(CParser *parser, CParser_Data *prev)
 {
     _cparser_check_semantics(parser);
+
+    // `ctype_get_qualified` also returns `NULL` for these, which is not the
+    // same as running out of memory.
+    if (prev->type.kind != CType_Kind_Basic && prev->type.kind != CType_Kind_Pointer)
+        _cparser_throw(parser, "Pointers to '%s' are not supported", ctype_kind_strings[prev->type.kind].data);
+
+    // Look up the pointee by structure; this is O(1) no matter how many
+    // levels of indirection came before it.
+    const CType_Info *info = ctype_get_qualified(parser->table, &prev->type, prev->qualifiers);
+    if (info == NULL)
+        _cparser_throw(parser, "Out of memory!");
+
     Allocator_Error error;
     CParser_Data   *pointer = mem_new(CParser_Data, &error, parser->allocator);
     if (error)
         _cparser_throw(parser, "Out of memory!");
 
-
-    char buf[256];
-    String_Builder builder = string_builder_make_fixed(buf, sizeof buf);
-    const char    *name    = cparser_canonicalize(parser, &builder);
-
-    printfln("Pointer to: '%s'", name);
-
-    // TODO: Works, but very inefficient!
-    const CType_Info *info = ctype_get(parser->table, name, string_builder_len(&builder));
+    printfln("Pointer to: '%s'", intern_lookup_id(parser->table->intern, info->name).data);
     *pointer = (CParser_Data){
         .prev        = prev,
         .type        = {.kind = CType_Kind_Pointer, .pointer = {.pointee = info, .qualifiers = 0}},
@@ -431,64 +438,3 @@ cparser_parse(CParser *parser, CLexer *lexer)
 
     __builtin_unreachable();
 }
-
-const char *
-cparser_canonicalize(CParser *parser, String_Builder *builder)
-{
-    CParser_Data *data = parser->data;
-    // e.g. given `int *`, our data is at `*` so print `int` first.
-    if (data->prev) {
-        parser->data = data->prev;
-        cparser_canonicalize(parser, builder);
-        parser->data = data;
-    }
-    
-    CType_QualifierFlag qualifiers = data->qualifiers;
-    const CType         type       = data->type;
-    bool                is_pointer = (type.kind == CType_Kind_Pointer);
-    if (!is_pointer) {
-        if (qualifiers & CType_QualifierFlag_Const)
-            string_append_literal(builder, "const ");
-        if (qualifiers & CType_QualifierFlag_Volatile)
-            string_append_literal(builder, "volatile ");
-    }
-
-    // No need to print the modifiers since they're already part of the basic types.
-    switch (type.kind) {
-    case CType_Kind_Invalid:
-        string_append_literal(builder, "<invalid>");
-        break;
-    case CType_Kind_Basic:
-        string_append_string(builder, type.basic.name);
-        break;
-    case CType_Kind_Pointer:
-        // Generally, don't poke at the `String_Builder` members directly.
-        // Doing it just this once...
-        if (builder->buffer[builder->len - 1] == '*')
-            string_append_char(builder, '*');
-        else
-            string_append_literal(builder, " *");
-        break;
-    case CType_Kind_Struct:
-    case CType_Kind_Enum:
-    case CType_Kind_Union:
-    default:
-        string_append_literal(builder, "<unimplemented>");
-        break;
-    }
-
-    if (is_pointer) {
-        if (qualifiers & CType_QualifierFlag_Const)
-            string_append_literal(builder, "const ");
-        if (qualifiers & CType_QualifierFlag_Volatile)
-            string_append_literal(builder, "volatile ");
-        if (qualifiers & CType_QualifierFlag_Restrict)
-            string_append_literal(builder, "restrict ");
-
-        // Remove the trailing whitespace for the last qualifier.
-        if (qualifiers != 0)
-            string_pop(builder);
-    }
-
-    return string_to_cstring(builder);
-}
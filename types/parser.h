@@ -31,10 +31,3 @@ cparser_init(CParser *parser, CType_Table *table, Allocator allocator);
  */
 bool
 cparser_parse(CParser *parser, CLexer *lexer);
-
-/**
- * @brief
- *      Returns the 'canonical' type name.
- */
-const char *
-cparser_canonicalize(CParser *parser, String_Builder *builder);
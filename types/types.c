@@ -1,5 +1,7 @@
 #include "../mem/arena.h"
 
+#include "../ascii.h"
+
 #include "types.h"
 #include "parser.h"
 
@@ -45,14 +47,235 @@ ctype_basic_types[CType_BasicKind_Count] = {
     {CType_Kind_Basic,   {{CType_BasicKind_Float,               CType_BasicFlag_Float,                              string_literal("float")}}},
     {CType_Kind_Basic,   {{CType_BasicKind_Double,              CType_BasicFlag_Float,                              string_literal("double")}}},
     {CType_Kind_Basic,   {{CType_BasicKind_Long_Double,         CType_BasicFlag_Float,                              string_literal("long double")}}},
-    {CType_Kind_Basic,   {{CType_BasicKind_Float,               CType_BasicFlag_Float | CType_BasicFlag_Complex,    string_literal("float complex")}}},
-    {CType_Kind_Basic,   {{CType_BasicKind_Double,              CType_BasicFlag_Float | CType_BasicFlag_Complex,    string_literal("double complex")}}},
-    {CType_Kind_Basic,   {{CType_BasicKind_Long_Double,         CType_BasicFlag_Float | CType_BasicFlag_Complex,    string_literal("long double complex")}}},
+    {CType_Kind_Basic,   {{CType_BasicKind_Float_Complex,       CType_BasicFlag_Float | CType_BasicFlag_Complex,    string_literal("float complex")}}},
+    {CType_Kind_Basic,   {{CType_BasicKind_Double_Complex,      CType_BasicFlag_Float | CType_BasicFlag_Complex,    string_literal("double complex")}}},
+    {CType_Kind_Basic,   {{CType_BasicKind_Long_Double_Complex, CType_BasicFlag_Float | CType_BasicFlag_Complex,    string_literal("long double complex")}}},
 
     // Misc. Types
     {CType_Kind_Basic,   {{CType_BasicKind_Void,               0,                                                   string_literal("void")}}},
 };
 
+//=== CANONICAL NAME INDEX ================================================= {{{
+
+/**
+ * @brief
+ *      Ids are handed out in order, so names interned together have
+ *      neighboring ids. Spread them with a multiplicative (Fibonacci) hash.
+ *      Its top bits are the well-mixed ones, so fold them onto the low bits
+ *      that `_ctype_map_probe()` masks off.
+ */
+static size_t
+_ctype_map_hash(Intern_Id name)
+{
+    uint64_t hash = cast(uint64_t)name * 0x9e3779b97f4a7c15ULL;
+    return cast(size_t)(hash ^ (hash >> 32));
+}
+
+/**
+ * @brief
+ *      Find the slot for `name` in `slots`. This is either the slot which
+ *      already has `name` or the empty slot where it would be inserted.
+ *
+ * @note
+ *      Assumes `cap` is a nonzero power of 2 and that there is always at least
+ *      1 empty slot, which the load factor in `_ctype_map_set()` guarantees.
+ */
+static CType_Entry *
+_ctype_map_probe(CType_Entry slots[], size_t cap, Intern_Id name)
+{
+    const size_t mask = cap - 1;
+    for (size_t i = _ctype_map_hash(name) & mask; /* empty */; i = (i + 1) & mask) {
+        if (slots[i].name == name || slots[i].name == INTERN_ID_NONE)
+            return &slots[i];
+    }
+}
+
+static Allocator_Error
+_ctype_map_resize(CType_Map *map, size_t new_cap, Allocator allocator)
+{
+    Allocator_Error error;
+    // Zeroed so that empty slots have `name == INTERN_ID_NONE`.
+    CType_Entry    *new_slots = mem_make_zeroed(CType_Entry, &error, new_cap, allocator);
+    if (error)
+        return error;
+
+    CType_Entry *old_slots = map->slots;
+    for (size_t i = 0, old_cap = map->cap; i < old_cap; ++i) {
+        if (old_slots[i].name == INTERN_ID_NONE)
+            continue;
+        *_ctype_map_probe(new_slots, new_cap, old_slots[i].name) = old_slots[i];
+    }
+
+    mem_delete(old_slots, map->cap, allocator);
+    map->slots = new_slots;
+    map->cap   = new_cap;
+    return Allocator_Error_None;
+}
+
+// e.g: 3 / 4 == 75%
+#define LF_NUMERATOR    3
+#define LF_DENOMINATOR  4
+
+/**
+ * @brief
+ *      Ensure the next `_ctype_map_set()` on `map` cannot fail.
+ */
+static Allocator_Error
+_ctype_map_reserve(CType_Map *map, Allocator allocator)
+{
+    size_t cap = map->cap;
+    if (map->len >= (cap * LF_NUMERATOR) / LF_DENOMINATOR)
+        return _ctype_map_resize(map, (cap == 0) ? 1 << 5 : cap << 1, allocator);
+    return Allocator_Error_None;
+}
+
+static Allocator_Error
+_ctype_map_set(CType_Map *map, CType_Entry entry, Allocator allocator)
+{
+    Allocator_Error error = _ctype_map_reserve(map, allocator);
+    if (error)
+        return error;
+
+    CType_Entry *slot = _ctype_map_probe(map->slots, map->cap, entry.name);
+    if (slot->name == INTERN_ID_NONE)
+        ++map->len;
+    *slot = entry;
+    return Allocator_Error_None;
+}
+
+#undef LF_NUMERATOR
+#undef LF_DENOMINATOR
+
+/**
+ * @return
+ *      The `info` mapped to `name`, or `NULL` if there is none.
+ */
+static CType_Info *
+_ctype_map_get(const CType_Map *map, Intern_Id name)
+{
+    // Empty slots have a `NULL` info, so a miss needs no special casing.
+    if (map->cap == 0)
+        return NULL;
+    return _ctype_map_probe(map->slots, map->cap, name)->info;
+}
+
+static void
+_ctype_map_destroy(CType_Map *map, Allocator allocator)
+{
+    mem_delete(map->slots, map->cap, allocator);
+    map->slots = NULL;
+    map->len   = 0;
+    map->cap   = 0;
+}
+
+//=== }}} ======================================================================
+
+//=== STRUCTURAL HASH-CONSING ============================================== {{{
+
+static size_t
+_ctype_cons_hash(const void *operand, CType_QualifierFlag qualifiers)
+{
+    uint64_t hash = cast(uint64_t)cast(uintptr_t)operand ^ cast(uint64_t)qualifiers;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return cast(size_t)hash;
+}
+
+// Same assumptions as `_ctype_map_probe()`.
+static CType_Cons_Entry *
+_ctype_cons_probe(CType_Cons_Entry slots[], size_t cap, const void *operand, CType_QualifierFlag qualifiers)
+{
+    const size_t mask = cap - 1;
+    for (size_t i = _ctype_cons_hash(operand, qualifiers) & mask; /* empty */; i = (i + 1) & mask) {
+        if (slots[i].operand == NULL)
+            return &slots[i];
+        if (slots[i].operand == operand && slots[i].qualifiers == qualifiers)
+            return &slots[i];
+    }
+}
+
+static Allocator_Error
+_ctype_cons_resize(CType_Cons_Map *map, size_t new_cap, Allocator allocator)
+{
+    Allocator_Error   error;
+    // Zeroed so that empty slots have `operand == NULL`.
+    CType_Cons_Entry *new_slots = mem_make_zeroed(CType_Cons_Entry, &error, new_cap, allocator);
+    if (error)
+        return error;
+
+    CType_Cons_Entry *old_slots = map->slots;
+    for (size_t i = 0, old_cap = map->cap; i < old_cap; ++i) {
+        CType_Cons_Entry entry = old_slots[i];
+        if (entry.operand == NULL)
+            continue;
+        *_ctype_cons_probe(new_slots, new_cap, entry.operand, entry.qualifiers) = entry;
+    }
+
+    mem_delete(old_slots, map->cap, allocator);
+    map->slots = new_slots;
+    map->cap   = new_cap;
+    return Allocator_Error_None;
+}
+
+// Same as `_ctype_map_reserve()`.
+static Allocator_Error
+_ctype_cons_reserve(CType_Cons_Map *map, Allocator allocator)
+{
+    // 3/4 load factor, same as `CType_Map`.
+    size_t cap = map->cap;
+    if (map->len >= (cap * 3) / 4)
+        return _ctype_cons_resize(map, (cap == 0) ? 1 << 5 : cap << 1, allocator);
+    return Allocator_Error_None;
+}
+
+static Allocator_Error
+_ctype_cons_set(CType_Cons_Map *map, CType_Cons_Entry entry, Allocator allocator)
+{
+    Allocator_Error error = _ctype_cons_reserve(map, allocator);
+    if (error)
+        return error;
+
+    CType_Cons_Entry *slot = _ctype_cons_probe(map->slots, map->cap, entry.operand, entry.qualifiers);
+    if (slot->operand == NULL)
+        ++map->len;
+    *slot = entry;
+    return Allocator_Error_None;
+}
+
+static CType_Info *
+_ctype_cons_get(const CType_Cons_Map *map, const void *operand, CType_QualifierFlag qualifiers)
+{
+    if (map->cap == 0)
+        return NULL;
+    return _ctype_cons_probe(map->slots, map->cap, operand, qualifiers)->info;
+}
+
+static void
+_ctype_cons_destroy(CType_Cons_Map *map, Allocator allocator)
+{
+    mem_delete(map->slots, map->cap, allocator);
+    map->slots = NULL;
+    map->len   = 0;
+    map->cap   = 0;
+}
+
+/**
+ * @brief
+ *      The structural identity of `type`. See `CType_Cons_Entry`.
+ */
+static const void *
+_ctype_cons_operand(const CType *type)
+{
+    switch (type->kind) {
+    case CType_Kind_Basic:   return &ctype_basic_types[type->basic.kind];
+    case CType_Kind_Pointer: return type->pointer.pointee;
+    default:                 return NULL;
+    }
+}
+
+//=== }}} ======================================================================
+
 Allocator_Error
 ctype_table_init(CType_Table *table, Intern *intern, Allocator allocator)
 {
@@ -67,27 +290,43 @@ ctype_table_init(CType_Table *table, Intern *intern, Allocator allocator)
         .entries   = entries,
         .len       = count_of(ctype_basic_types),
         .cap       = count_of(ctype_basic_types),
+        .index     = {NULL, 0, 0},
+        .cache     = {NULL, 0, 0},
+        .cons      = {NULL, 0, 0},
     };
+    pool_init_type(&table->info_pool, CType_Info, allocator);
+    pool_init_type(&table->type_pool, CType, allocator);
+
+    // All of their infos in 1 go; they likely all fit in the first slab.
+    void *infos[CType_BasicKind_Count];
+    if (!pool_rawalloc_many(&table->info_pool, infos, count_of(infos)))
+        return Allocator_Error_Out_Of_Memory;
 
     // Add all the unqualified basic types
     for (size_t i = 0; i < count_of(ctype_basic_types); ++i) {
-        const CType          type = ctype_basic_types[i];
-        const Intern_String *name = intern_get_interned(intern, type.basic.name);
-        if (name == NULL)
+        const CType type = ctype_basic_types[i];
+        Intern_Id   name = intern_get_id(intern, type.basic.name);
+        if (name == INTERN_ID_NONE)
             return Allocator_Error_Out_Of_Memory;
 
-        CType_Info *info = mem_new(CType_Info, &error, allocator);
-        if (error)
-            return error;
-
+        CType_Info *info = cast(CType_Info *)infos[i];
         *info = (CType_Info){
-            .name       = name,
             .type       = &ctype_basic_types[i],
+            .name       = name,
             .qualifiers = 0,
             .is_owner   = false,
         };
         entries[i].name = name;
         entries[i].info = info;
+
+        error = _ctype_map_set(&table->index, entries[i], allocator);
+        if (error)
+            return error;
+
+        CType_Cons_Entry cons = {.operand = info->type, .qualifiers = 0, .info = info};
+        error = _ctype_cons_set(&table->cons, cons, allocator);
+        if (error)
+            return error;
     }
     return Allocator_Error_None;
 }
@@ -98,77 +337,176 @@ ctype_table_destroy(CType_Table *table)
     Allocator    allocator = table->allocator;
     CType_Entry *entries   = table->entries;
     for (size_t i = 0, len = table->len; i < len; ++i) {
-        CType_Info *info = entries[i].info;
+        const CType_Info *info = entries[i].info;
         // the unqualified basic types are allocated in read-only memory, so
         // `info->is_owner` will be false.
-        if (info->is_owner) {
-            printfln("Freeing '%s'...", info->name->data);
-            mem_free(cast(CType *)info->type, allocator);
-        }
-        mem_free(info, allocator);
+        if (info->is_owner)
+            printfln("Freeing '%s'...", intern_lookup_id(table->intern, info->name).data);
     }
+    // Every `info` and owned `type` goes away with its pool, all at once.
+    pool_destroy(&table->info_pool);
+    pool_destroy(&table->type_pool);
     mem_delete(entries, table->cap, allocator);
+    _ctype_map_destroy(&table->index, allocator);
+    _ctype_map_destroy(&table->cache, allocator);
+    _ctype_cons_destroy(&table->cons, allocator);
     table->entries = NULL;
     table->len     = 0;
     table->cap     = 0;
 }
 
+/**
+ * @brief
+ *      Write the canonical name of `type` qualified by `qualifiers`, e.g.
+ *      `const char *const *restrict`. This is the only spelling of a type that
+ *      `index` and the cache ever see. Pointee names are looked up in `intern`.
+ */
+static Allocator_Error
+_ctype_write_name(String_Builder *builder, const Intern *intern, const CType *type, CType_QualifierFlag qualifiers)
+{
+    Allocator_Error error = Allocator_Error_None;
+    if (type->kind == CType_Kind_Basic) {
+        if (qualifiers & CType_QualifierFlag_Const)
+            error = error ? error : string_append_literal(builder, "const ");
+        if (qualifiers & CType_QualifierFlag_Volatile)
+            error = error ? error : string_append_literal(builder, "volatile ");
+        return error ? error : string_append_string(builder, type->basic.name);
+    }
+
+    // Pointers. The pointee was interned by us, so its name is already canonical.
+    String name = intern_lookup_id(intern, type->pointer.pointee->name);
+    error = string_append_string(builder, name);
+
+    // Stack asterisks, e.g. `int **` rather than `int * *`.
+    if (name.len > 0 && name.data[name.len - 1] == '*')
+        error = error ? error : string_append_char(builder, '*');
+    else
+        error = error ? error : string_append_literal(builder, " *");
+
+    if (qualifiers & CType_QualifierFlag_Const)
+        error = error ? error : string_append_literal(builder, "const ");
+    if (qualifiers & CType_QualifierFlag_Volatile)
+        error = error ? error : string_append_literal(builder, "volatile ");
+    if (qualifiers & CType_QualifierFlag_Restrict)
+        error = error ? error : string_append_literal(builder, "restrict ");
+
+    // Remove the trailing whitespace for the last qualifier.
+    if (!error && qualifiers != 0)
+        string_pop(builder);
+    return error;
+}
+
 static const CType_Info *
-_ctype_add(CType_Table *table, CParser *parser, const Intern_String *name)
+_ctype_add(CType_Table *table, const CType *type, CType_QualifierFlag qualifiers)
 {
+    // The name only needs to live until it is interned.
+    Arena_Temp     scratch = global_temp_allocator_begin();
+    String_Builder builder = string_builder_make(global_temp_allocator);
+    Intern_Id      name    = INTERN_ID_NONE;
+    if (!_ctype_write_name(&builder, table->intern, type, qualifiers))
+        name = intern_get_id(table->intern, string_to_string(&builder));
+    arena_temp_end(scratch);
+    if (name == INTERN_ID_NONE)
+        return NULL;
+
     Allocator allocator = table->allocator;
     size_t    old_cap   = table->cap;
     // Need to resize?
     if (table->len >= old_cap) {
         // NOTE: assume `table->cap` is never 0 by this point!
-        size_t          new_cap = old_cap * 2;
+        size_t          new_size;
         Allocator_Error error;
-        CType_Entry    *entries = mem_resize(CType_Entry, &error, table->entries, old_cap, new_cap, allocator);
+        CType_Entry    *entries = mem_resize_sized(CType_Entry, &error, table->entries, old_cap, old_cap * 2, allocator, &new_size);
         if (error)
             return NULL;
 
+        // Take any slack the allocator gave us as extra capacity.
         table->entries = entries;
-        table->cap     = new_cap;
+        table->cap     = new_size / sizeof(entries[0]);
     }
 
+    // Make room up front so that nothing can fail once `info` exists.
+    if (_ctype_map_reserve(&table->index, allocator) || _ctype_cons_reserve(&table->cons, allocator))
+        return NULL;
 
-    Allocator_Error error;
-    CType_Info     *info = mem_new(CType_Info, &error, allocator);
-    if (error)
+    CType_Info *info = cast(CType_Info *)pool_rawalloc(&table->info_pool);
+    if (info == NULL)
         return NULL;
 
-    CType type = parser->data->type;
-    if (type.kind == CType_Kind_Basic) {
+    if (type->kind == CType_Kind_Basic) {
         *info = (CType_Info){
+            .type       = &ctype_basic_types[type->basic.kind],
             .name       = name,
-            .type       = &ctype_basic_types[type.basic.kind],
-            .qualifiers = parser->data->qualifiers,
+            .qualifiers = cast(uint8_t)qualifiers,
             .is_owner   = false,
         };
     } else {
-        CType *_type = mem_new(CType, &error, allocator);
-        if (error) {
-            mem_free(info, allocator);
+        CType *_type = cast(CType *)pool_rawalloc(&table->type_pool);
+        if (_type == NULL) {
+            pool_rawfree(&table->info_pool, info);
             return NULL;
         }
 
-        *_type = parser->data->type;
+        *_type = *type;
         *info = (CType_Info){
-            .name       = name,
             .type       = _type,
-            .qualifiers = parser->data->qualifiers,
+            .name       = name,
+            .qualifiers = cast(uint8_t)qualifiers,
             .is_owner   = true,
         };
     }
 
-    CType_Entry *entry = &table->entries[table->len++];
-    entry->name = name;
-    entry->info = info;
+    CType_Entry      entry = {.name = name, .info = info};
+    CType_Cons_Entry cons  = {.operand = _ctype_cons_operand(type), .qualifiers = qualifiers, .info = info};
+    _ctype_map_set(&table->index, entry, allocator);
+    _ctype_cons_set(&table->cons, cons, allocator);
+    table->entries[table->len++] = entry;
     return info;
 }
 
 const CType_Info *
-ctype_get(CType_Table *table, const char *text, size_t len)
+ctype_get_qualified(CType_Table *table, const CType *type, CType_QualifierFlag qualifiers)
+{
+    const void *operand = _ctype_cons_operand(type);
+    if (operand == NULL)
+        return NULL;
+
+    const CType_Info *info = _ctype_cons_get(&table->cons, operand, qualifiers);
+    if (info != NULL)
+        return info;
+    return _ctype_add(table, type, qualifiers);
+}
+
+/**
+ * @brief
+ *      Write `text` with leading and trailing whitespace removed and every
+ *      inner run of whitespace collapsed to 1 space. This way `"unsigned  long"`
+ *      and `" unsigned long\t"` share the same cache entry.
+ */
+static Allocator_Error
+_ctype_write_cache_key(String_Builder *builder, String text)
+{
+    bool in_space = false;
+
+    text = string_trim_space(text);
+    string_for_each(ch, text) {
+        if (ascii_is_whitespace(ch)) {
+            in_space = true;
+            continue;
+        }
+        Allocator_Error error = Allocator_Error_None;
+        if (in_space)
+            error = string_append_char(builder, ' ');
+        error = error ? error : string_append_char(builder, ch);
+        if (error)
+            return error;
+        in_space = false;
+    }
+    return Allocator_Error_None;
+}
+
+static const CType_Info *
+_ctype_parse(CType_Table *table, const char *text, size_t len)
 {
     CLexer  lexer  = clexer_make(text, len);
     CParser parser;
@@ -178,21 +516,62 @@ ctype_get(CType_Table *table, const char *text, size_t len)
     if (!cparser_parse(&parser, &lexer))
         return NULL;
 
-    // WARNING: May not be enough!
-    char buf[256];
-    String_Builder builder = string_builder_make_fixed(buf, sizeof buf);
-    cparser_canonicalize(&parser, &builder);
-    const Intern_String *name = intern_get_interned(table->intern, string_to_string(&builder));
+    const CParser_Data *data = parser.data;
+    return ctype_get_qualified(table, &data->type, data->qualifiers);
+}
 
-    // TODO: Use canonical name as a hash lookup
-    CType_Entry *entries = table->entries;
-    for (size_t i = 0, len = table->len; i < len; ++i) {
-        CType_Entry entry = entries[i];
-        if (entry.name == name) {
-            return entry.info;
+static const CType_Info *
+_ctype_get(CType_Table *table, const char *text, size_t len)
+{
+    String         spelling = {text, len};
+    String_Builder builder  = string_builder_make(global_temp_allocator);
+    bool           has_key  = !_ctype_write_cache_key(&builder, spelling);
+    String         key      = string_to_string(&builder);
+
+    // Only look the key up for now. Spellings that fail to parse, typos
+    // included, should not stay interned forever.
+    if (has_key) {
+        const Intern_String *interned = intern_find(table->intern, key);
+        const CType_Info    *info     = (interned != NULL) ? _ctype_map_get(&table->cache, interned->id) : NULL;
+        if (info != NULL) {
+            ++table->cache_hits;
+            return info;
         }
     }
-    return _ctype_add(table, &parser, name);
+
+    ++table->cache_misses;
+    const CType_Info *info = _ctype_parse(table, text, len);
+
+    // The cache is purely an optimization, so failing to grow it is fine.
+    if (info != NULL && has_key) {
+        CType_Entry entry = {.name = intern_get_id(table->intern, key), .info = cast(CType_Info *)info};
+        if (entry.name != INTERN_ID_NONE)
+            _ctype_map_set(&table->cache, entry, table->allocator);
+    }
+    return info;
+}
+
+const CType_Info *
+ctype_get(CType_Table *table, const char *text, size_t len)
+{
+    // Everything we allocate along the way is scratch: the cache key, the
+    // parser's data and any names we build. Release all of it on the way out.
+    Arena_Temp        scratch = global_temp_allocator_begin();
+    const CType_Info *info    = _ctype_get(table, text, len);
+    arena_temp_end(scratch);
+    return info;
+}
+
+void
+ctype_table_clear_cache(CType_Table *table)
+{
+    _ctype_map_destroy(&table->cache, table->allocator);
+}
+
+const CType_Info *
+ctype_table_lookup(const CType_Table *table, Intern_Id name)
+{
+    return _ctype_map_get(&table->index, name);
 }
 
 void
@@ -204,13 +583,14 @@ ctype_table_print(const CType_Table *table)
     for (size_t i = 0, len = table->len; i < len; ++i) {
         const CType_Info *info = entries[i].info;
         const CType      *type = info->type;
-        printf("[%zu]: '%s'", i, entries[i].name->data);
+        printf("[%zu]: '%s'", i, intern_lookup_id(table->intern, entries[i].name).data);
 
         if (type->kind == CType_Kind_Pointer) {
-            printfln(" -> '%s'", type->pointer.pointee->name->data);
+            printfln(" -> '%s'", intern_lookup_id(table->intern, type->pointer.pointee->name).data);
         } else {
             println("");
         }
     }
+    printfln("Cache: %zu hits, %zu misses", table->cache_hits, table->cache_misses);
     println("=============\n");
 }
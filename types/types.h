@@ -6,6 +6,7 @@
 
 #include "../strings.h"
 #include "../intern.h"
+#include "../mem/pool.h"
 
 /**
  * @brief
@@ -107,10 +108,10 @@ typedef enum {
  *      base types or not.
  */
 typedef struct {
-    const Intern_String *name;       // Canonical name.
-    const CType         *type;       // Multiple `CType_Info` can refer to the same `CType`.
-    CType_QualifierFlag  qualifiers; // Bit set of `CType_QualifierFlag`.
-    bool                 is_owner;   // `type` is dynamically-allocated and we own it?
+    const CType *type;       // Multiple `CType_Info` can refer to the same `CType`.
+    Intern_Id    name;       // Canonical name, see `intern_lookup_id()`.
+    uint8_t      qualifiers; // Bit set of `CType_QualifierFlag`.
+    bool         is_owner;   // `type` is dynamically-allocated and we own it?
 } CType_Info;
 
 /**
@@ -188,21 +189,72 @@ extern const CType
 ctype_basic_types[CType_BasicKind_Count];
 
 typedef struct {
-    const Intern_String *name; // Canonical name.
-    CType_Info          *info; // Each is dynamically allocated so they can be shared.
+    Intern_Id   name; // Canonical name.
+    CType_Info *info; // Each is dynamically allocated so they can be shared.
 } CType_Entry;
 
+/**
+ * @brief
+ *      An open-addressed hash map of `CType_Entry`, keyed by the `name` id.
+ *      Since names are interned, id equality is string equality.
+ *
+ * @note
+ *      Empty slots have a `name` of `INTERN_ID_NONE`. Entries are never removed
+ *      individually so we don't need tombstones.
+ */
+typedef struct {
+    CType_Entry *slots;
+    size_t       len;
+    size_t       cap; // Must always be a power of 2.
+} CType_Map;
+
+/**
+ * @brief
+ *      Identifies a type by its structure rather than by its name.
+ *
+ *      `operand` is the `CType` in `ctype_basic_types` for basic types, and the
+ *      pointee `CType_Info` for pointer types. Both are unique per type, so no
+ *      two different types can ever share a key.
+ */
+typedef struct {
+    const void         *operand;
+    CType_QualifierFlag qualifiers;
+    CType_Info         *info;
+} CType_Cons_Entry;
+
+/**
+ * @brief
+ *      An open-addressed hash map of `CType_Cons_Entry`. Empty slots have an
+ *      `operand` of `NULL`.
+ */
+typedef struct {
+    CType_Cons_Entry *slots;
+    size_t            len;
+    size_t            cap; // Must always be a power of 2.
+} CType_Cons_Map;
+
 /**
  * @note
  *      The indexes, 0 up to `CType_BasicKind_Count - 1`, must be of type
  *      `CType_BasicKind`. They must be unqualified.
+ *
+ *      Every `CType_Info`, and every `CType` owned by one, comes from
+ *      `info_pool` and `type_pool` respectively rather than from `allocator`
+ *      directly. Their slabs still come from `allocator`.
  */
 typedef struct {
-    Allocator    allocator;
-    Intern      *intern;
-    CType_Entry *entries;
-    size_t       len;
-    size_t       cap;
+    Allocator      allocator;
+    Intern        *intern;
+    CType_Entry   *entries;
+    size_t         len;
+    size_t         cap;
+    CType_Map      index; // Maps canonical names to the same `info` as in `entries`.
+    CType_Map      cache; // Maps whitespace-normalized spellings given to `ctype_get`.
+    size_t         cache_hits;
+    size_t         cache_misses;
+    CType_Cons_Map cons;  // Maps the structure of each type in `entries` to its `info`.
+    Pool           info_pool;
+    Pool           type_pool;
 } CType_Table;
 
 Allocator_Error
@@ -211,9 +263,50 @@ ctype_table_init(CType_Table *table, Intern *intern, Allocator allocator);
 void
 ctype_table_destroy(CType_Table *table);
 
+/**
+ * @brief
+ *      Get the type spelled by `text`, adding it to `table` if it is new.
+ *
+ * @note
+ *      Spellings are cached after whitespace normalization, so repeated
+ *      queries for e.g. `"const  char *"` never reach the lexer nor the parser.
+ *      See `cache_hits` and `cache_misses` in `table` for the hit rate.
+ */
 const CType_Info *
 ctype_get(CType_Table *table, const char *text, size_t len);
 
+/**
+ * @brief
+ *      Forget every cached spelling and give the cache's memory back. The
+ *      types themselves stay; their spellings are simply parsed again.
+ */
+void
+ctype_table_clear_cache(CType_Table *table);
+
+/**
+ * @brief
+ *      Get the unique `CType_Info` for `type` qualified by `qualifiers`,
+ *      adding it to `table` if it is new. Nothing is parsed, and a name is
+ *      only built when a new type is added.
+ *
+ * @note
+ *      Only basic and pointer types are supported. For pointers, `qualifiers`
+ *      should match `type->pointer.qualifiers`.
+ */
+const CType_Info *
+ctype_get_qualified(CType_Table *table, const CType *type, CType_QualifierFlag qualifiers);
+
+/**
+ * @brief
+ *      Find the type whose canonical name is exactly `name`. Unlike `ctype_get`
+ *      this never parses nor adds anything.
+ *
+ * @return
+ *      The matching `CType_Info` or `NULL` if `name` is not in the table.
+ */
+const CType_Info *
+ctype_table_lookup(const CType_Table *table, Intern_Id name);
+
 void
 ctype_table_print(const CType_Table *table);
 